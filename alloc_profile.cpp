@@ -0,0 +1,187 @@
+#include "alloc_profile.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <algorithm>
+
+using namespace std;
+
+// Nothing in here may allocate with operator new: the tables come from calloc
+
+namespace {
+
+const int MAX_PHASES = 128;
+const int MAX_DEPTH = 64;
+// Bytes in front of every block holding its size (keeps malloc's 16-byte alignment)
+const size_t HEADER = 16;
+
+struct PhaseStats {
+    const char* name;
+    uint64_t count, bytes, frees;
+    int64_t peak;
+};
+
+struct ThreadTable {
+    PhaseStats phases[MAX_PHASES];  // phases[0] is "(no span)"
+    int used;
+    int stack[MAX_DEPTH];           // open phases, innermost last
+    int depth;
+    ThreadTable* next;
+};
+
+atomic<ThreadTable*> tables{nullptr};
+atomic<int64_t> live{0}, peak_live{0};
+bool reported = false;
+
+void report();
+
+ThreadTable* this_thread_table(){
+    thread_local ThreadTable* table = nullptr;
+    if (!table) {
+        static bool registered = (atexit(report), true);
+        (void)registered;
+        table = (ThreadTable*)calloc(1, sizeof(ThreadTable));
+        if (!table) abort();
+        table->phases[0].name = "(no span)";
+        table->used = 1;
+        ThreadTable* head = tables.load();
+        do table->next = head;
+        while (!tables.compare_exchange_weak(head, table));
+    }
+    return table;
+}
+
+// Innermost stored phase; spans nested deeper than MAX_DEPTH count for their outer one
+int current(const ThreadTable* t){
+    return t->depth ? t->stack[min(t->depth, MAX_DEPTH) - 1] : 0;
+}
+
+int64_t add_live(int64_t delta){
+    int64_t now = live.fetch_add(delta, memory_order_relaxed) + delta;
+    int64_t top = peak_live.load(memory_order_relaxed);
+    while (now > top && !peak_live.compare_exchange_weak(top, now, memory_order_relaxed)) {}
+    return now;
+}
+
+void* allocate(size_t size){
+    char* base = (char*)malloc(size + HEADER);
+    if (!base) return nullptr;
+    *(size_t*)base = size;
+    int64_t now = add_live(size);
+    ThreadTable* t = this_thread_table();
+    PhaseStats& p = t->phases[current(t)];
+    p.count++;
+    p.bytes += size;
+    if (now > p.peak) p.peak = now;
+    return base + HEADER;
+}
+
+void release(void* ptr){
+    if (!ptr) return;
+    char* base = (char*)ptr - HEADER;
+    add_live(-(int64_t)*(size_t*)base);
+    ThreadTable* t = this_thread_table();
+    t->phases[current(t)].frees++;
+    free(base);
+}
+
+// Phases of all threads merged by name, largest byte count first
+void report(){
+    if (reported) return;
+    reported = true;
+    static PhaseStats total[MAX_PHASES];
+    int n = 0;
+    for (ThreadTable* t = tables.load(); t; t = t->next) {
+        for (int i = 0; i < t->used; ++i) {
+            const PhaseStats& p = t->phases[i];
+            int k = 0;
+            while (k < n && strcmp(total[k].name, p.name) != 0) ++k;
+            if (k == n) {
+                if (n == MAX_PHASES) continue;
+                total[n++] = {p.name, 0, 0, 0, 0};
+            }
+            total[k].count += p.count;
+            total[k].bytes += p.bytes;
+            total[k].frees += p.frees;
+            if (p.peak > total[k].peak) total[k].peak = p.peak;
+        }
+    }
+    for (int i = 1; i < n; ++i)
+        for (int j = i; j > 0 && total[j].bytes > total[j - 1].bytes; --j) {
+            PhaseStats tmp = total[j];
+            total[j] = total[j - 1];
+            total[j - 1] = tmp;
+        }
+
+    fprintf(stderr, "\nAllocation profile (peak live heap %.1f MB)\n", peak_live.load() / 1048576.0);
+    fprintf(stderr, "%-20s %12s %12s %14s %14s\n", "phase", "allocs", "frees", "bytes", "peak live MB");
+    for (int k = 0; k < n; ++k) {
+        if (!total[k].count && !total[k].frees) continue;
+        fprintf(stderr, "%-20s %12llu %12llu %14llu %14.1f\n", total[k].name, (unsigned long long)total[k].count,
+                (unsigned long long)total[k].frees, (unsigned long long)total[k].bytes, total[k].peak / 1048576.0);
+    }
+}
+
+}
+
+void alloc_phase_push(const char* name){
+    ThreadTable* t = this_thread_table();
+    int slot = 0;
+    while (slot < t->used && t->phases[slot].name != name) ++slot;
+    if (slot == t->used) {
+        if (t->used < MAX_PHASES) t->phases[t->used++].name = name;
+        else slot = 0;  // table full: charged to "(no span)"
+    }
+    if (t->depth < MAX_DEPTH) t->stack[t->depth] = slot;
+    t->depth++;
+}
+
+void alloc_phase_pop(){
+    ThreadTable* t = this_thread_table();
+    if (t->depth > 0) t->depth--;
+}
+
+void* operator new(size_t size){
+    void* p = allocate(size);
+    if (!p) throw bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size){
+    return operator new(size);
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new[](size_t size, const nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    release(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    release(ptr);
+}
+
+void operator delete(void* ptr, const nothrow_t&) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void* ptr, const nothrow_t&) noexcept {
+    release(ptr);
+}
@@ -0,0 +1,18 @@
+#ifndef _ALLOC_PROFILE_H
+#define _ALLOC_PROFILE_H
+
+// Allocation profiling, built in with `make ALLOC_PROFILE=1` (defines ALLOC_PROFILE).
+//
+// alloc_profile.cpp then replaces the global operator new/delete. Every allocation is
+// charged to the phase of the allocating thread, the innermost TraceSpan (see trace.h) open
+// on it, or "(no span)". At exit a table with the allocation count, the bytes allocated and
+// the peak live heap seen while the phase was running is printed to stderr per phase.
+//
+// Counting takes no lock: each thread keeps its own table, which is never freed so the
+// report still sees threads that have ended.
+
+// Called by TraceSpan; `name` must outlive the process (string literal)
+void alloc_phase_push(const char* name);
+void alloc_phase_pop();
+
+#endif
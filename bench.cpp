@@ -0,0 +1,127 @@
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "mazeroute.h"
+
+using namespace std;
+
+// Time-to-quality benchmark: routes a maze in every mode under a series of deadlines and
+// reports the routed net count as a fraction of the optimum, read from the .opt sidecar
+// written by `maze_generator --planted` unless given with --optimum, and the cells the
+// searches expanded. Without an optimum only the counts are printed.
+
+void usage(){
+    cout << "Usage: ./bench MAZE.txt [--optimum N] [--budgets S1,S2,...] [--modes bfs,astar,hadlock,lineprobe,ilp,portfolio] [--max-iter N] [--threads N]\n";
+    exit(1);
+}
+
+vector<string> split(const string& s){
+    vector<string> parts;
+    stringstream ss(s);
+    string part;
+    while (getline(ss, part, ',')) parts.push_back(part);
+    return parts;
+}
+
+int main(int argc, char** argv){
+    if (argc < 2) usage();
+    string maze_file = argv[1];
+    int optimum = -1;
+    vector<string> budgets = {"0.05", "0.2", "1", "5"};
+    vector<string> modes = {"bfs", "astar", "hadlock", "ilp"};
+    int max_iteration = 3;
+    int threads = 1;
+    for (int i = 2; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--optimum" && i + 1 < argc) optimum = stoi(argv[++i]);
+        else if (arg == "--budgets" && i + 1 < argc) budgets = split(argv[++i]);
+        else if (arg == "--modes" && i + 1 < argc) modes = split(argv[++i]);
+        else if (arg == "--max-iter" && i + 1 < argc) max_iteration = stoi(argv[++i]);
+        else if (arg == "--threads" && i + 1 < argc) threads = stoi(argv[++i]);
+        else usage();
+    }
+
+    ifstream input(maze_file);
+    if (input.fail()) {
+        cout << "Cannot read the input file!\n";
+        return 1;
+    }
+    stringstream buffer;
+    buffer << input.rdbuf();
+    string maze = buffer.str();
+
+    if (optimum < 0) {
+        string sidecar = maze_file.substr(0, maze_file.rfind('.')) + ".opt";
+        ifstream opt(sidecar);
+        string key;
+        while (opt >> key)
+            if (key == "optimum") opt >> optimum;
+        if (optimum < 0)
+            cout << "No optimum (pass --optimum N or generate the maze with maze_generator --planted)\n";
+    }
+
+    cout << "Maze " << maze_file;
+    if (optimum >= 0) cout << ", optimum " << optimum << " nets";
+    cout << "\n\n" << left << setw(11) << "mode" << setw(10) << "budget" << setw(12) << "elapsed s" << setw(8) << "routed"
+         << setw(10) << "fraction" << "expanded\n";
+
+    for (const string& mode : modes) {
+        RouteOptions options;
+        if (mode == "bfs") options.algorithm = RouteOptions::BFS;
+        else if (mode == "astar") options.algorithm = RouteOptions::ASTAR;
+        else if (mode == "hadlock") options.algorithm = RouteOptions::HADLOCK;
+        else if (mode == "lineprobe") options.algorithm = RouteOptions::LINEPROBE;
+        else if (mode == "ilp") options.algorithm = RouteOptions::ILP;
+        else if (mode == "portfolio") options.algorithm = RouteOptions::ILP, options.portfolio = true;
+        else {
+            cout << "Unknown mode: " << mode << "\n";
+            return 1;
+        }
+        options.max_iteration = max_iteration;
+        options.thread_count = threads;
+        options.search_threads = threads;
+
+        double time_to_optimum = -1;
+        MazeRouter router;
+        for (const string& budget : budgets) {
+            Grid g;
+            string error;
+            istringstream in(maze);
+            if (!parse_maze(in, g, error)) {
+                cout << error << "\n";
+                return 1;
+            }
+            options.deadline = stod(budget);
+            options.time_limit = options.deadline;
+
+            auto t0 = chrono::steady_clock::now();
+            map<int,int> result = router.route(g, options);
+            double elapsed = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+            int routed = 0;
+            for (const auto& [id, steps] : result)
+                if (steps > 0) routed++;
+            double fraction = optimum > 0 ? (double)routed / optimum : 1.0;
+            if (optimum >= 0 && fraction >= 1.0 && time_to_optimum < 0) time_to_optimum = elapsed;
+            cout << left << setw(11) << mode << setw(10) << budget << setw(12) << fixed << setprecision(3) << elapsed
+                 << setw(8) << routed << setw(10);
+            if (optimum >= 0) cout << setprecision(3) << fraction;
+            else cout << "-";
+            cout << router.router.expanded_cells;
+            if (options.algorithm == RouteOptions::LINEPROBE) cout << " (" << router.router.probes << " probes)";
+            cout << "\n";
+        }
+        if (optimum < 0) {
+            cout << "\n";
+            continue;
+        }
+        cout << mode << ": ";
+        if (time_to_optimum >= 0) cout << "optimum reached in " << time_to_optimum << " s\n\n";
+        else cout << "optimum not reached within the budgets\n\n";
+    }
+    return 0;
+}
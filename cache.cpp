@@ -0,0 +1,129 @@
+#include "cache.h"
+#include "result_io.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <thread>
+#include <vector>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+
+// 64-bit FNV-1a
+struct Hasher {
+    uint64_t h = 1469598103934665603ULL;
+
+    void bytes(const void* data, size_t len){
+        const unsigned char* p = (const unsigned char*)data;
+        for (size_t i = 0; i < len; ++i) {
+            h ^= p[i];
+            h *= 1099511628211ULL;
+        }
+    }
+    void integer(int v){ bytes(&v, sizeof(v)); }
+};
+
+}
+
+ResultCache::ResultCache(const string& dir, uint64_t max_bytes) : dir(dir), max_bytes(max_bytes) {}
+
+string ResultCache::key(const Grid& g, const string& options) const {
+    Hasher h;
+    h.integer(FORMAT);
+    h.integer(ResultWriter::VERSION);
+    h.integer(g.M);
+    h.integer(g.N);
+    // The parsed cells, so formatting differences in the input file do not matter
+    for (const auto& row : g.grid) {
+        for (const Cell& c : row) {
+            char type = c.is_obstacle ? '#' : c.is_start ? 'S' : c.is_end ? 'E' : '.';
+            h.bytes(&type, 1);
+            if (c.is_start || c.is_end) h.integer(c.path_id);
+        }
+    }
+    h.bytes(options.data(), options.size());
+
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)h.h);
+    return hex;
+}
+
+string ResultCache::entry_path(const string& key) const {
+    return (fs::path(dir) / (key + ".mzrb")).string();
+}
+
+bool ResultCache::load(const string& key, Grid& g, map<int,int>& id_to_steps){
+    string path = entry_path(key);
+    error_code ec;
+    if (!fs::exists(path, ec)) return false;
+
+    RoutedResult result;
+    if (!read_results(path, result) || !apply_results(result, g, id_to_steps)) {
+        fs::remove(path, ec);  // stale or damaged entry
+        return false;
+    }
+    // The modification time doubles as the last-use time for eviction
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    return true;
+}
+
+bool ResultCache::store(const string& key, const Grid& g, const map<int,int>& id_to_steps){
+    error_code ec;
+    fs::create_directories(dir, ec);
+
+    // Unique temporary name so concurrent runs never see a partly written entry
+    string path = entry_path(key);
+    string tmp = path + ".tmp" + to_string(hash<thread::id>()(this_thread::get_id()) ^
+                                           chrono::steady_clock::now().time_since_epoch().count());
+    if (!write_results(tmp, g, id_to_steps, true)) {
+        fs::remove(tmp, ec);
+        return false;
+    }
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        return false;
+    }
+    evict();
+    return true;
+}
+
+// Drops stale temporary files, then the least recently used entries until the cache fits in
+// max_bytes
+void ResultCache::evict(){
+    struct Entry {
+        fs::file_time_type used;
+        uint64_t size;
+        fs::path path;
+    };
+    vector<Entry> entries;
+    uint64_t total = 0;
+
+    error_code ec;
+    auto stale = fs::file_time_type::clock::now() - chrono::seconds(TMP_MAX_AGE);
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        error_code size_ec, time_ec;
+        uint64_t size = it->file_size(size_ec);
+        fs::file_time_type used = it->last_write_time(time_ec);
+        if (size_ec || time_ec) continue;
+        // <key>.mzrb.tmp<n>, which another run may still be writing
+        if (it->path().extension().string().rfind(".tmp", 0) == 0 && it->path().stem().extension() == ".mzrb") {
+            if (used < stale) fs::remove(it->path(), time_ec);
+            continue;
+        }
+        if (it->path().extension() != ".mzrb") continue;
+        entries.push_back({used, size, it->path()});
+        total += size;
+    }
+    if (total <= max_bytes) return;
+
+    sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.used < b.used; });
+    for (const Entry& e : entries) {
+        if (total <= max_bytes) break;
+        if (fs::remove(e.path, ec)) total -= e.size;
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef _CACHE_H
+#define _CACHE_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include "objects.h"
+
+using namespace std;
+
+// On-disk cache of routing results, addressed by a hash of the parsed maze and the options
+// that change the result. Entries are binary result files (see result_io.h) named
+// <key>.mzrb; they are written to a temporary file and renamed into place, and the least
+// recently used ones are evicted once the directory grows past `max_bytes`. Temporary files
+// left by runs that died while writing are removed once they are TMP_MAX_AGE seconds old.
+class ResultCache {
+public:
+    // Bump when the key derivation or the meaning of a cached result changes
+    static const int FORMAT = 1;
+    // Longer than any store() takes
+    static constexpr int TMP_MAX_AGE = 600;
+
+    ResultCache(const string& dir, uint64_t max_bytes);
+
+    // `options` spells out everything besides the maze that the result depends on
+    string key(const Grid& g, const string& options) const;
+
+    // On a hit the cached routes are committed to `g`, which must still be unrouted
+    bool load(const string& key, Grid& g, map<int,int>& id_to_steps);
+    bool store(const string& key, const Grid& g, const map<int,int>& id_to_steps);
+
+private:
+    string entry_path(const string& key) const;
+    void evict();
+
+    string dir;
+    uint64_t max_bytes;
+};
+
+#endif
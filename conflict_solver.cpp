@@ -0,0 +1,373 @@
+#include "conflict_solver.h"
+#include "trace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+
+using namespace std;
+
+static function<unique_ptr<ComponentSolver>()> default_factory;
+
+bool SharedIncumbent::offer(const vector<int>& list, Finder by){
+    if ((int)list.size() <= best_size) return false;
+    {
+        lock_guard<mutex> guard(lock);
+        if ((int)list.size() <= best_size) return false;
+        chosen = list;
+        sort(chosen.begin(), chosen.end());
+        finder = by;
+        best_size = list.size();
+    }
+    check();
+    return true;
+}
+
+void SharedIncumbent::tighten(int bound){
+    for (int old = upper; bound < old && !upper.compare_exchange_weak(old, bound);) {}
+    check();
+}
+
+vector<int> SharedIncumbent::best() const {
+    lock_guard<mutex> guard(lock);
+    return chosen;
+}
+
+SharedIncumbent::Finder SharedIncumbent::found_by() const {
+    lock_guard<mutex> guard(lock);
+    return finder;
+}
+
+// Good enough once the best is within `gap` of the bound
+void SharedIncumbent::check(){
+    if (best_size >= upper - (int)(gap * upper)) stop = true;
+}
+
+bool ComponentSolver::race(const PathPool& paths, const vector<int>& members, const vector<CutConstraint>& cuts,
+                           double time_limit, int worker, SharedIncumbent& shared){
+    shared.offer(solve(paths, members, cuts, time_limit, worker), SharedIncumbent::EXACT);
+    return false;
+}
+
+unique_ptr<ComponentSolver> default_component_solver(){
+    if (default_factory) return default_factory();
+    return unique_ptr<ComponentSolver>(new LocalSolver());
+}
+
+void set_default_component_solver(function<unique_ptr<ComponentSolver>()> factory){
+    default_factory = move(factory);
+}
+
+vector<vector<int>> conflict_graph(const PathPool& paths, const vector<int>& members){
+    unordered_map<int, vector<int>> users;  // cell -> positions in members
+    for (size_t i = 0; i < members.size(); ++i)
+        for (int cell : paths[members[i]])
+            users[cell].push_back(i);
+
+    vector<vector<int>> adj(members.size());
+    for (const auto& [cell, list] : users)
+        for (size_t a = 0; a < list.size(); ++a)
+            for (size_t b = a + 1; b < list.size(); ++b) {
+                adj[list[a]].push_back(list[b]);
+                adj[list[b]].push_back(list[a]);
+            }
+    for (auto& neighbors : adj) {
+        sort(neighbors.begin(), neighbors.end());
+        neighbors.erase(unique(neighbors.begin(), neighbors.end()), neighbors.end());
+    }
+    return adj;
+}
+
+vector<int> greedy_disjoint(const PathPool& paths, const vector<int>& members){
+    vector<vector<int>> adj = conflict_graph(paths, members);
+    int n = members.size();
+    vector<int> degree(n);
+    vector<bool> alive(n, true);
+    for (int i = 0; i < n; ++i) degree[i] = adj[i].size();
+
+    vector<int> chosen;
+    for (int left = n; left > 0;) {
+        // fewest conflicts first, shorter paths break ties
+        int pick = -1;
+        for (int i = 0; i < n; ++i) {
+            if (!alive[i]) continue;
+            if (pick == -1 || degree[i] < degree[pick] ||
+                (degree[i] == degree[pick] && paths[members[i]].size() < paths[members[pick]].size()))
+                pick = i;
+        }
+        chosen.push_back(members[pick]);
+        alive[pick] = false;
+        left--;
+        for (int v : adj[pick]) {
+            if (!alive[v]) continue;
+            alive[v] = false;
+            left--;
+            for (int w : adj[v]) degree[w]--;
+        }
+    }
+    return chosen;
+}
+
+int cut_bound(int n, const vector<CutConstraint>& cuts, vector<int>* used){
+    // largest excess first; a member counted by two cuts would make the bound invalid
+    vector<int> order(cuts.size());
+    iota(order.begin(), order.end(), 0);
+    auto excess = [&](int k) { return (int)cuts[k].members.size() - cuts[k].limit; };
+    sort(order.begin(), order.end(), [&](int a, int b) { return excess(a) != excess(b) ? excess(a) > excess(b) : a < b; });
+
+    vector<bool> taken(n, false);
+    int bound = n;
+    for (int k : order) {
+        if (excess(k) <= 0) break;
+        bool free = true;
+        for (int i : cuts[k].members) free = free && !taken[i];
+        if (!free) continue;
+        for (int i : cuts[k].members) taken[i] = true;
+        bound -= excess(k);
+        if (used) used->push_back(k);
+    }
+    return bound;
+}
+
+// Exact maximum independent set on at most 64 vertices
+namespace {
+
+struct BranchAndBound {
+    vector<uint64_t> adj;
+    vector<uint64_t> cut_masks;     // cuts sharing no vertex, with at most cut_limits[k] chosen
+    vector<int> cut_limits;
+    uint64_t best_set = 0;
+    int best = 0;
+    chrono::steady_clock::time_point deadline;
+    long long nodes = 0;
+    bool timed_out = false;
+    // While racing: the best of the other solvers raises `best`, ours is offered to them
+    SharedIncumbent* shared = nullptr;
+    const vector<int>* members = nullptr;
+
+    void search(uint64_t cand, uint64_t cur, int cur_size){
+        if (timed_out) return;
+        if ((++nodes & 1023) == 0) {
+            if (chrono::steady_clock::now() > deadline || (shared && shared->stopped())) {
+                timed_out = true;
+                return;
+            }
+            if (shared) best = max(best, shared->size());
+        }
+
+        // vertices without conflicts among the candidates are always taken
+        uint64_t isolated = 0;
+        int pick = -1, pick_degree = -1;
+        for (uint64_t rest = cand; rest; rest &= rest - 1) {
+            int v = __builtin_ctzll(rest);
+            int degree = __builtin_popcountll(adj[v] & cand);
+            if (degree == 0) isolated |= 1ULL << v;
+            else if (degree > pick_degree) pick = v, pick_degree = degree;
+        }
+        cur |= isolated;
+        cur_size += __builtin_popcountll(isolated);
+        cand &= ~isolated;
+
+        if (!cand) {
+            if (cur_size > best) {
+                best = cur_size, best_set = cur;
+                if (shared) offer(cur);
+            }
+            return;
+        }
+        int bound = cur_size + __builtin_popcountll(cand);
+        for (size_t k = 0; k < cut_masks.size(); ++k) {
+            int room = max(0, cut_limits[k] - __builtin_popcountll(cur & cut_masks[k]));
+            bound -= max(0, __builtin_popcountll(cand & cut_masks[k]) - room);
+        }
+        if (bound <= best) return;
+
+        uint64_t bit = 1ULL << pick;
+        search(cand & ~adj[pick] & ~bit, cur | bit, cur_size + 1);
+        search(cand & ~bit, cur, cur_size);
+    }
+
+    void offer(uint64_t set){
+        vector<int> chosen;
+        for (size_t i = 0; i < members->size(); ++i)
+            if (set >> i & 1) chosen.push_back((*members)[i]);
+        shared->offer(chosen, SharedIncumbent::EXACT);
+    }
+
+    // Conflict bit masks of `members` and the cuts of `used`
+    void build(const PathPool& paths, const vector<int>& members, const vector<CutConstraint>& cuts,
+               const vector<int>& used){
+        int n = members.size();
+        adj.assign(n, 0);
+        vector<vector<int>> lists = conflict_graph(paths, members);
+        for (int i = 0; i < n; ++i)
+            for (int j : lists[i]) adj[i] |= 1ULL << j;
+        for (int k : used) {
+            uint64_t mask = 0;
+            for (int i : cuts[k].members) mask |= 1ULL << i;
+            cut_masks.push_back(mask);
+            cut_limits.push_back(cuts[k].limit);
+        }
+    }
+};
+
+}
+
+vector<int> LocalSolver::solve(const PathPool& paths, const vector<int>& members, const vector<CutConstraint>& cuts,
+                               double time_limit, int worker){
+    vector<int> greedy = greedy_disjoint(paths, members);
+    int n = members.size();
+    if (n > exact_limit || n > 64 || (int)greedy.size() == n) return greedy;
+    // the cuts may already prove the greedy answer optimal
+    vector<int> used;
+    if ((int)greedy.size() >= cut_bound(n, cuts, &used)) return greedy;
+
+    BranchAndBound bb;
+    bb.build(paths, members, cuts, used);
+
+    // the greedy answer is the initial bound
+    bb.best = greedy.size();
+    bb.deadline = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(
+                      chrono::duration<double>(time_limit));
+    bb.search(n == 64 ? ~0ULL : (1ULL << n) - 1, 0, 0);
+    if (!bb.best_set) return greedy;
+
+    vector<int> chosen;
+    for (int i = 0; i < n; ++i)
+        if (bb.best_set >> i & 1) chosen.push_back(members[i]);
+    return chosen;
+}
+
+bool LocalSolver::race(const PathPool& paths, const vector<int>& members, const vector<CutConstraint>& cuts,
+                       double time_limit, int worker, SharedIncumbent& shared){
+    int n = members.size();
+    // Greedy only, which the race starts from
+    if (n > exact_limit || n > 64) return false;
+    vector<int> used;
+    shared.tighten(cut_bound(n, cuts, &used));
+    if (shared.stopped()) return shared.proven();
+
+    BranchAndBound bb;
+    bb.build(paths, members, cuts, used);
+    bb.shared = &shared;
+    bb.members = &members;
+    bb.best = shared.size();
+    bb.deadline = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(
+                      chrono::duration<double>(time_limit));
+    bb.search(n == 64 ? ~0ULL : (1ULL << n) - 1, 0, 0);
+    if (bb.timed_out) return false;
+    // Searched through: nothing beats the best either side found
+    shared.tighten(max(bb.best, shared.size()));
+    return true;
+}
+
+vector<int> ConflictSolver::solve(const PathPool& all_paths){
+    TraceSpan span("conflict_solve");
+    auto start = chrono::steady_clock::now();
+    auto deadline = start + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(time_limit));
+    stats = ConflictStats();
+    stats.paths = all_paths.size();
+
+    // Union-find over paths that share a cell
+    int n = all_paths.size();
+    vector<int> parent(n);
+    iota(parent.begin(), parent.end(), 0);
+    auto find = [&](int a) {
+        while (parent[a] != a) a = parent[a] = parent[parent[a]];
+        return a;
+    };
+    unordered_map<int, int> first_user;
+    first_user.reserve(all_paths.cell_count());
+    for (int p = 0; p < n; ++p) {
+        for (int cell : all_paths[p]) {
+            auto [it, inserted] = first_user.emplace(cell, p);
+            if (!inserted) parent[find(p)] = find(it->second);
+        }
+    }
+
+    unordered_map<int, vector<int>> by_root;
+    for (int p = 0; p < n; ++p) by_root[find(p)].push_back(p);
+
+    vector<int> selected;
+    vector<vector<int>> components;
+    for (auto& [root, members] : by_root) {
+        if (members.size() == 1) selected.push_back(members[0]);  // conflict-free
+        else components.push_back(move(members));
+    }
+    stats.conflict_free = selected.size();
+    stats.components = components.size();
+
+    // Largest components first so the long solves start early
+    sort(components.begin(), components.end(), [](const vector<int>& a, const vector<int>& b) {
+        return a.size() != b.size() ? a.size() > b.size() : a[0] < b[0];
+    });
+    if (!components.empty()) stats.largest = components[0].size();
+
+    // Cardinality constraints of every component from the vertex cuts
+    vector<vector<CutConstraint>> component_cuts(components.size());
+    if (cuts && !cuts->empty()) {
+        vector<int> component_of(n, -1), position(n);
+        for (size_t c = 0; c < components.size(); ++c)
+            for (size_t i = 0; i < components[c].size(); ++i)
+                component_of[components[c][i]] = c, position[components[c][i]] = i;
+
+        unordered_map<int, vector<int>> cuts_at;  // cell -> cuts through it
+        for (size_t k = 0; k < cuts->size(); ++k)
+            for (int cell : (*cuts)[k]) cuts_at[cell].push_back(k);
+        vector<vector<int>> crossing(cuts->size());  // paths through every cut
+        for (int p = 0; p < n; ++p) {
+            if (component_of[p] < 0) continue;
+            for (int cell : all_paths[p]) {
+                auto it = cuts_at.find(cell);
+                if (it == cuts_at.end()) continue;
+                for (int k : it->second)
+                    if (crossing[k].empty() || crossing[k].back() != p) crossing[k].push_back(p);
+            }
+        }
+        for (size_t k = 0; k < cuts->size(); ++k) {
+            int limit = (*cuts)[k].size();
+            auto& list = crossing[k];
+            stable_sort(list.begin(), list.end(), [&](int a, int b) { return component_of[a] < component_of[b]; });
+            for (size_t lo = 0, hi; lo < list.size(); lo = hi) {
+                for (hi = lo; hi < list.size() && component_of[list[hi]] == component_of[list[lo]]; ++hi) {}
+                if ((int)(hi - lo) <= limit) continue;
+                CutConstraint cut{{}, limit};
+                for (size_t j = lo; j < hi; ++j) cut.members.push_back(position[list[j]]);
+                component_cuts[component_of[list[lo]]].push_back(move(cut));
+                stats.cut_constraints++;
+            }
+        }
+        stats.cuts = cuts->size();
+    }
+
+    vector<vector<int>> chosen(components.size());
+    int workers = max(1, min(thread_count, (int)components.size()));
+    component_solver.prepare(workers, max(1, thread_count / workers));
+
+    atomic<size_t> next{0};
+    auto work = [&](int worker) {
+        for (size_t c; (c = next++) < components.size();) {
+            TraceSpan component_span("component", "paths", components[c].size());
+            double remaining = chrono::duration<double>(deadline - chrono::steady_clock::now()).count();
+            if (remaining > 0)
+                chosen[c] = component_solver.solve(all_paths, components[c], component_cuts[c], remaining, worker);
+            if (chosen[c].empty())
+                chosen[c] = greedy_disjoint(all_paths, components[c]);
+        }
+    };
+    vector<thread> pool;
+    for (int w = 1; w < workers; ++w) pool.emplace_back(work, w);
+    work(0);
+    for (auto& t : pool) t.join();
+    for (size_t c = 0; c < components.size(); ++c)
+        if (!component_cuts[c].empty() && (int)chosen[c].size() >= cut_bound(components[c].size(), component_cuts[c]))
+            stats.proved_by_cuts++;
+
+    for (const auto& list : chosen) selected.insert(selected.end(), list.begin(), list.end());
+    sort(selected.begin(), selected.end());
+    stats.solve_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return selected;
+}
@@ -0,0 +1,142 @@
+#ifndef _CONFLICT_SOLVER_H
+#define _CONFLICT_SOLVER_H
+
+using namespace std;
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include "path.h"
+
+// At most `limit` of the paths at positions `members` of a component can be chosen together
+// (they all cross the same `limit` cells, see cut_analysis.h)
+struct CutConstraint {
+    vector<int> members;
+    int limit;
+};
+
+// Best choice of one component found so far by the solvers racing on it (see portfolio.h),
+// with the best upper bound any of them proved. The race stops once the best choice is within
+// `gap` of the bound (gap 0: proven optimal).
+class SharedIncumbent {
+public:
+    enum Finder { GREEDY, LOCAL_SEARCH, EXACT };
+
+    SharedIncumbent(int bound, double gap) : upper(bound), gap(gap) {}
+
+    // Keeps `chosen` (a subset of the component's members) if it has more paths than the best
+    // so far; returns true if it did
+    bool offer(const vector<int>& chosen, Finder finder);
+    // Some solver proved that no choice has more than `bound` paths
+    void tighten(int bound);
+    vector<int> best() const;           // the best choice, sorted
+    int size() const { return best_size; }
+    int bound() const { return upper; }
+    Finder found_by() const;            // who offered the best choice
+    bool stopped() const { return stop; }       // the best is within `gap` of the bound
+    bool proven() const { return best_size >= upper; }
+
+private:
+    void check();
+
+    mutable mutex lock;
+    vector<int> chosen;
+    Finder finder = GREEDY;
+    atomic<int> best_size{0}, upper;
+    atomic<bool> stop{false};
+    const double gap;
+};
+
+// Picks a largest set of pairwise disjoint paths inside one connected component of the
+// conflict graph. solve() is called concurrently from several worker threads; `worker`
+// (0 .. workers - 1) identifies the calling thread so implementations can keep
+// per-thread state without locking.
+class ComponentSolver {
+public:
+    virtual ~ComponentSolver() {}
+
+    // Called once before a batch of components is solved; `threads` is what each worker may
+    // use inside one solve() (the thread count left over when there are fewer components)
+    virtual void prepare(int workers, int threads) {}
+    // `members` are indices into `paths`; returns the chosen subset of them. An empty result
+    // means no solution was found in time (the caller falls back to a greedy choice). `cuts`
+    // are valid constraints of the component the solver may use to tighten its bounds.
+    virtual vector<int> solve(const PathPool& paths, const vector<int>& members, const vector<CutConstraint>& cuts,
+                              double time_limit, int worker) = 0;
+    // Same while racing other solvers: starts from shared.best() when it can, offers what it
+    // finds as it goes and returns soon after shared.stopped(). Returns true if it proved its
+    // bound (tightened in `shared`); the default just offers the result of solve().
+    virtual bool race(const PathPool& paths, const vector<int>& members, const vector<CutConstraint>& cuts,
+                      double time_limit, int worker, SharedIncumbent& shared);
+};
+
+// Solver without external dependencies: exact branch and bound on the conflict graph of
+// components up to `exact_limit` paths, minimum-degree greedy above that. The cuts lower the
+// upper bound of the branch and bound.
+class LocalSolver : public ComponentSolver {
+public:
+    vector<int> solve(const PathPool& paths, const vector<int>& members, const vector<CutConstraint>& cuts,
+                      double time_limit, int worker) override;
+    // The branch and bound prunes with the shared best as it improves
+    bool race(const PathPool& paths, const vector<int>& members, const vector<CutConstraint>& cuts,
+              double time_limit, int worker, SharedIncumbent& shared) override;
+
+    int exact_limit = 64;
+};
+
+struct ConflictStats {
+    int paths = 0;
+    int components = 0;       // components with at least two paths
+    int conflict_free = 0;    // paths accepted without solving
+    int largest = 0;          // paths in the largest component
+    int cuts = 0;             // vertex cuts found by the pre-analysis
+    int cut_constraints = 0;  // cardinality constraints they gave to the components
+    int proved_by_cuts = 0;   // components whose choice meets the bound of their cuts (optimal)
+    double cut_seconds = 0;   // time of the pre-analysis
+    double solve_seconds = 0;
+};
+
+// Splits the candidate paths into connected components of their conflict graph (two paths
+// conflict when they share a cell), accepts conflict-free paths right away and solves the
+// remaining components in parallel. All components share one time limit.
+//
+// With cuts set, each one becomes a cardinality constraint of every component with more
+// paths through the cut than it has cells. The solvers stop early when a greedy choice
+// already reaches the bound those constraints give.
+class ConflictSolver {
+public:
+    explicit ConflictSolver(ComponentSolver& solver) : component_solver(solver) {}
+
+    // Returns the indices of the selected paths
+    vector<int> solve(const PathPool& all_paths);
+
+    void set_time_limit(double seconds) { time_limit = seconds; }
+    void set_thread_count(int count) { thread_count = count; }
+    // Vertex cuts (sorted linear cell indices) for the next solve(); nullptr for none
+    void set_cuts(const vector<vector<int>>* vertex_cuts) { cuts = vertex_cuts; }
+
+    ConflictStats stats;
+
+private:
+    ComponentSolver& component_solver;
+    const vector<vector<int>>* cuts = nullptr;
+    double time_limit = 30.0;
+    int thread_count = 1;
+};
+
+// Solver used by Router::route_with_ilp when none is passed in: LocalSolver, unless the
+// application registered another one (main registers Gurobi when built WITH_GUROBI).
+unique_ptr<ComponentSolver> default_component_solver();
+void set_default_component_solver(function<unique_ptr<ComponentSolver>()> factory);
+
+// Builds the conflict adjacency of `members` (adj[i] lists positions in `members`)
+vector<vector<int>> conflict_graph(const PathPool& paths, const vector<int>& members);
+// Minimum-degree greedy independent set; returns a subset of `members`
+vector<int> greedy_disjoint(const PathPool& paths, const vector<int>& members);
+// Upper bound on the paths chosen among `n` from cut constraints that share no member
+// (positions of `cuts` in the returned list; the bound is n minus their excess)
+int cut_bound(int n, const vector<CutConstraint>& cuts, vector<int>* used = nullptr);
+
+#endif
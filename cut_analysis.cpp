@@ -0,0 +1,135 @@
+#include "cut_analysis.h"
+#include "deadline.h"
+#include "trace.h"
+#include <algorithm>
+#include <atomic>
+#include <set>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+// Vertex max-flow on the tube of cells within `margin` (Chebyshev distance) of a candidate.
+// Every open cell i of the tube is split into an in-node 2i and an out-node 2i + 1 joined by
+// a unit edge, so a min cut only cuts cells.
+struct TubeFlow {
+    vector<int> head, next, to, cap;
+    vector<int> tube;           // tube index -> linear grid index
+    vector<int> local, mark;    // linear grid index -> tube index, valid where mark == stamp
+    vector<int> prev_edge, seen, queue;
+    int stamp = 0, visit = 0;
+
+    void add_edge(int a, int b, int c){
+        to.push_back(b), cap.push_back(c), next.push_back(head[a]), head[a] = to.size() - 1;
+        to.push_back(a), cap.push_back(0), next.push_back(head[b]), head[b] = to.size() - 1;
+    }
+
+    // BFS over the residual graph; true if `sink` was reached
+    bool augmenting_path(int source, int sink){
+        visit++;
+        queue.assign(1, source);
+        seen[source] = visit;
+        for (size_t k = 0; k < queue.size(); ++k) {
+            int v = queue[k];
+            for (int e = head[v]; e != -1; e = next[e]) {
+                int w = to[e];
+                if (cap[e] == 0 || seen[w] == visit) continue;
+                seen[w] = visit;
+                prev_edge[w] = e;
+                if (w == sink) return true;
+                queue.push_back(w);
+            }
+        }
+        return false;
+    }
+
+    // Appends the min cut between the end points of `path` to `cut` if it has at most
+    // max_size cells
+    void run(const Grid& g, const PathView& path, int margin, int max_size, vector<int>& cut){
+        int M = g.M, N = g.N;
+        if (mark.empty()) local.assign((size_t)M * N, 0), mark.assign((size_t)M * N, 0);
+        stamp++;
+        int s = path[path.size() - 1], e = path[0];
+
+        // Open cells as in the candidate search of the net
+        tube.clear();
+        for (int k = 0; k < path.size(); ++k) {
+            int px = path.x(k), py = path.y(k);
+            for (int x = max(0, px - margin); x <= min(M - 1, px + margin); ++x)
+                for (int y = max(0, py - margin); y <= min(N - 1, py + margin); ++y) {
+                    int c = x * N + y;
+                    if (mark[c] == stamp) continue;
+                    mark[c] = stamp;
+                    local[c] = -1;
+                    const Cell& cell = g.grid[x][y];
+                    if (!cell.is_obstacle && (c == s || c == e || (cell.is_space && cell.path_id == -1))) {
+                        local[c] = tube.size();
+                        tube.push_back(c);
+                    }
+                }
+        }
+
+        const int BIG = max_size + 2;
+        int T = tube.size();
+        head.assign(2 * T, -1);
+        next.clear(), to.clear(), cap.clear();
+        for (int i = 0; i < T; ++i) {
+            int c = tube[i], x = c / N, y = c % N;
+            add_edge(2 * i, 2 * i + 1, c == s || c == e ? BIG : 1);
+            // towards x + 1 and y + 1, both directions, so every pair is joined once
+            int down = x + 1 < M && mark[c + N] == stamp ? local[c + N] : -1;
+            int right = y + 1 < N && mark[c + 1] == stamp ? local[c + 1] : -1;
+            for (int j : {down, right}) {
+                if (j < 0) continue;
+                add_edge(2 * i + 1, 2 * j, BIG);
+                add_edge(2 * j + 1, 2 * i, BIG);
+            }
+        }
+
+        int source = 2 * local[s] + 1, sink = 2 * local[e];
+        if (seen.size() < head.size()) seen.resize(head.size(), 0), prev_edge.resize(head.size());
+
+        int flow = 0;
+        while (augmenting_path(source, sink)) {
+            if (++flow > max_size) return;
+            for (int v = sink; v != source; v = to[prev_edge[v] ^ 1]) {
+                cap[prev_edge[v]]--;
+                cap[prev_edge[v] ^ 1]++;
+            }
+        }
+        if (flow == 0) return;
+
+        // The last search marked the source side: its cells whose out-node was not reached
+        for (int i = 0; i < T; ++i)
+            if (seen[2 * i] == visit && seen[2 * i + 1] != visit)
+                cut.push_back(tube[i]);
+        sort(cut.begin(), cut.end());
+    }
+};
+
+}
+
+vector<vector<int>> find_vertex_cuts(const Grid& g, const PathPool& paths, int max_size, int margin, int threads,
+                                     const Deadline* deadline){
+    TraceSpan span("find_vertex_cuts");
+    vector<vector<int>> found(paths.size());
+    atomic<size_t> next{0};
+    auto work = [&]() {
+        TubeFlow flow;
+        for (size_t p; (p = next++) < paths.size();) {
+            if (deadline && deadline->expired()) break;
+            if (paths[p].size() > 2) flow.run(g, paths[p], margin, max_size, found[p]);
+        }
+    };
+    vector<thread> pool;
+    for (int t = 1; t < min<int>(threads, paths.size()); ++t) pool.emplace_back(work);
+    work();
+    for (auto& t : pool) t.join();
+
+    vector<vector<int>> cuts;
+    set<vector<int>> known;
+    for (auto& cut : found)
+        if (!cut.empty() && known.insert(cut).second) cuts.push_back(move(cut));
+    return cuts;
+}
@@ -0,0 +1,27 @@
+#ifndef _CUT_ANALYSIS_H
+#define _CUT_ANALYSIS_H
+
+#include <vector>
+#include "objects.h"
+#include "path.h"
+
+using namespace std;
+
+class Deadline;
+
+// Pre-analysis of the ILP candidates: small vertex cuts of the free-cell graph.
+//
+// For every candidate path a vertex max-flow is run from its start to its end over the free
+// cells within `margin` cells of the path, a tube as narrow as the corridors looked for. When
+// at most `max_size` cell-disjoint routes exist there, the min cut is a set C of free cells
+// that the candidate crosses. Selected paths are disjoint and every one using a cell of C
+// occupies a cell of its own there, so at most |C| of the candidates touching C can be chosen
+// together: a valid cardinality constraint for the conflict components (see
+// ConflictSolver::set_cuts).
+//
+// Returns the distinct cuts as sorted linear cell indices (x * N + y). Nets are analysed on
+// `threads` threads; the result does not depend on the thread count.
+vector<vector<int>> find_vertex_cuts(const Grid& g, const PathPool& paths, int max_size = 3, int margin = 2,
+                                     int threads = 1, const Deadline* deadline = nullptr);
+
+#endif
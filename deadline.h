@@ -0,0 +1,40 @@
+#ifndef _DEADLINE_H
+#define _DEADLINE_H
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+using namespace std;
+
+// Wall-clock budget shared by every phase of a run. A default-constructed Deadline never expires.
+class Deadline {
+public:
+    Deadline() {}
+    explicit Deadline(double seconds)
+        : limited(true),
+          end(chrono::steady_clock::now() +
+              chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(seconds))) {}
+
+    bool is_limited() const { return limited; }
+    bool expired() const { return limited && chrono::steady_clock::now() >= end; }
+
+    // Seconds left, never negative; infinity when unlimited
+    double remaining() const {
+        if (!limited) return numeric_limits<double>::infinity();
+        return max(0.0, chrono::duration<double>(end - chrono::steady_clock::now()).count());
+    }
+
+    // A deadline `seconds` earlier than this one, leaving that much time for later phases
+    Deadline reserve(double seconds) const {
+        Deadline d = *this;
+        if (limited) d.end -= chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(seconds));
+        return d;
+    }
+
+private:
+    bool limited = false;
+    chrono::steady_clock::time_point end;
+};
+
+#endif
@@ -94,6 +94,8 @@ void saveRoutingResults() {
         for (const auto& [id, steps] : id_to_steps) {
             if (steps == -1)
                 outFile << "Routing failed for net_id " << id << "\n";
+            else if (steps == NOT_ATTEMPTED)
+                outFile << "Routing not attempted for net_id " << id << " (deadline)\n";
             else
                 outFile << "route id: " << id << " => steps: " << steps << "\n";
         }
@@ -137,7 +139,7 @@ bool handleButtonClick(const sf::Vector2f& mousePos, sf::RenderWindow& window, c
 
 
 // Function to check if mouse is over a path cell
-void updateHoverState(const Grid& g, sf::RenderWindow& window, const int cellSize) {
+void updateHoverState(const Grid& g, const vector<int>& owner, sf::RenderWindow& window, const int cellSize) {
     // Get mouse position in world coordinates
     sf::Vector2f worldPos = window.mapPixelToCoords(sf::Mouse::getPosition(window));
     mouse_position = sf::Mouse::getPosition(window);
@@ -148,8 +150,9 @@ void updateHoverState(const Grid& g, sf::RenderWindow& window, const int cellSiz
     
     if (row >= 0 && row < g.M && col >= 0 && col < g.N) {
         const Cell& cell = g.grid[row][col];
-        if (cell.path_id != -1 && !cell.is_start && !cell.is_end) {
-            hovered_path_id = cell.path_id;
+        int path_id = owner[(size_t)row * g.N + col];
+        if (path_id != -1 && !cell.is_start && !cell.is_end) {
+            hovered_path_id = path_id;
         } else {
             hovered_path_id = -1;
         }
@@ -165,16 +168,17 @@ void updateHoverState(const Grid& g, sf::RenderWindow& window, const int cellSiz
 }
 
 // render Maze
-void renderMaze(const Grid& g, sf::RenderWindow& window, const int cellSize) {
+void renderMaze(const Grid& g, const vector<int>& owner, sf::RenderWindow& window, const int cellSize) {
     // Initialize buttons if not already done
     initButtons(window);
 
     // Update hover state
-    updateHoverState(g, window, cellSize);
+    updateHoverState(g, owner, window, cellSize);
 
     for (int i = 0; i < g.M; ++i) {
         for (int j = 0; j < g.N; ++j) {
             const Cell& cell = g.grid[i][j];
+            int path_id = owner[(size_t)i * g.N + j];
             sf::RectangleShape rect(sf::Vector2f(cellSize, cellSize));
             rect.setPosition(j * cellSize, i * cellSize);
 
@@ -182,12 +186,12 @@ void renderMaze(const Grid& g, sf::RenderWindow& window, const int cellSize) {
             if (cell.is_obstacle) {
                 rect.setFillColor(sf::Color::Black); // obstacle
             }           
-            else if (cell.path_id != -1) {
+            else if (path_id != -1) {
                 if(cell.is_start)
                     rect.setFillColor(sf::Color::Blue); // start
                 else if(cell.is_end)
                     rect.setFillColor(sf::Color::Red); // end
-                else if(cell.path_id == hovered_path_id)
+                else if(path_id == hovered_path_id)
                     rect.setFillColor(sf::Color(128, 0, 128)); // purple for hovered path
                 else
                     rect.setFillColor(sf::Color(0, 255, 0)); // route
@@ -200,7 +204,7 @@ void renderMaze(const Grid& g, sf::RenderWindow& window, const int cellSize) {
             
             // render RoutingNumber
             if (cell.is_start || cell.is_end) {
-                renderRoutingNumber(g, window, cellSize, cell.path_id);    
+                renderRoutingNumber(g, window, cellSize, path_id);    
             }        
         }
     }
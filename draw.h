@@ -6,11 +6,13 @@
 #include <string>
 #include <unordered_map>
 #include <map>
+#include <vector>
 
 using namespace std;
 
 // Function declarations
-void renderMaze(const Grid& g, sf::RenderWindow& window, const int cellSize);
+// owner[i * g.N + j] is the path_id to draw for cell (i, j), see RouteFrame
+void renderMaze(const Grid& g, const vector<int>& owner, sf::RenderWindow& window, const int cellSize);
 void renderRoutingNumber(const Grid& g, sf::RenderWindow& window, const int cellSize, const int path_id);
 bool handleButtonClick(const sf::Vector2f& mousePos, sf::RenderWindow& window, const float PanelHeightRate);
 
@@ -0,0 +1,108 @@
+#include "frontier_search.h"
+#include "deadline.h"
+#include <algorithm>
+#include <cstdint>
+
+using namespace std;
+
+int FrontierSearch::search(const Grid& g, int rid, int start, int end, const Deadline* deadline, vector<int>& route){
+    this->g = &g;
+    this->rid = rid;
+    this->deadline = deadline;
+    int mid, dist_a;
+    int dist = meet(start, end, mid, dist_a);
+    if (dist < 0) return dist == -1 ? 0 : dist;
+    route.push_back(start);
+    int status = recover(start, mid, dist_a, route);
+    if (status == 0) status = recover(mid, end, dist - dist_a, route);
+    return status < 0 ? status : 1;
+}
+
+// Free cells, the net's own end point and the end points of the current sub-search
+bool FrontierSearch::open(int c) const {
+    if (c == from || c == to) return true;
+    const Cell& cell = g->grid[c / g->N][c % g->N];
+    return (cell.is_end && cell.path_id == rid) || (cell.is_space && cell.path_id == -1);
+}
+
+// next = neighbours of `cur` not in `prev`. Grids are bipartite, so no neighbour lies in `cur`.
+// `next` never grows past `room` cells; returns false if it would have to.
+bool FrontierSearch::expand(const vector<int>& prev, const vector<int>& cur, vector<int>& next, size_t room) const {
+    const int M = g->M, N = g->N;
+    next.clear();
+    for (int c : cur) {
+        int x = c / N, y = c % N;
+        int nbr[4] = {x + 1 < M ? c + N : -1, x > 0 ? c - N : -1, y + 1 < N ? c + 1 : -1, y > 0 ? c - 1 : -1};
+        for (int n : nbr) {
+            if (n < 0 || !open(n) || binary_search(prev.begin(), prev.end(), n)) continue;
+            if (next.size() == next.capacity()) {
+                if (next.size() >= room) return false;
+                next.reserve(min(max<size_t>(2 * next.capacity(), 16), room));
+            }
+            next.push_back(n);
+        }
+    }
+    sort(next.begin(), next.end());
+    next.erase(unique(next.begin(), next.end()), next.end());
+    return true;
+}
+
+// Grows the two frontiers in turn until they meet. Every step adds one to the sum of their
+// radii, so the first cell found in both lies on a shortest route; the forward side goes
+// first, so for a distance of 2 or more the cell is neither a nor b.
+int FrontierSearch::meet(int a, int b, int& mid, int& dist_a){
+    if (a == b) {
+        mid = a, dist_a = 0;
+        return 0;
+    }
+    from = a, to = b;
+    vector<int> fprev, fcur = {a}, bprev, bcur = {b}, next;
+    int fdist = 0, bdist = 0;
+    for (bool forward = true;; forward = !forward) {
+        vector<int>& prev = forward ? fprev : bprev;
+        vector<int>& cur = forward ? fcur : bcur;
+        const vector<int>& other = forward ? bcur : fcur;
+        // The layers are the whole search state; the cap bounds their allocated size
+        size_t kept = fprev.capacity() + fcur.capacity() + bprev.capacity() + bcur.capacity();
+        size_t room = cap ? cap / sizeof(int) - min(cap / sizeof(int), kept) : SIZE_MAX;
+        if (!expand(prev, cur, next, room)) return OVER_CAP;
+        if (next.empty()) return -1;
+        (forward ? fdist : bdist)++;
+        peak_bytes = max(peak_bytes, (kept + next.capacity()) * sizeof(int));
+        expansions += next.size();
+        if (deadline && expansions >= 4096) {
+            expansions = 0;
+            if (deadline->expired()) return NOT_ATTEMPTED;
+        }
+
+        // Both lists are sorted: merge them for the smallest common cell
+        auto i = next.begin();
+        auto j = other.begin();
+        while (i != next.end() && j != other.end()) {
+            if (*i < *j) ++i;
+            else if (*j < *i) ++j;
+            else {
+                mid = *i;
+                dist_a = fdist;
+                return fdist + bdist;
+            }
+        }
+        prev.swap(cur);
+        cur.swap(next);
+    }
+}
+
+// Appends the cells after a up to b of a shortest route `dist` long
+int FrontierSearch::recover(int a, int b, int dist, vector<int>& route){
+    if (dist == 0) return 0;
+    if (dist == 1) {
+        route.push_back(b);
+        return 0;
+    }
+    int mid, dist_a;
+    int found = meet(a, b, mid, dist_a);
+    if (found < 0) return found;
+    int status = recover(a, mid, dist_a, route);
+    if (status < 0) return status;
+    return recover(mid, b, found - dist_a, route);
+}
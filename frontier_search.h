@@ -0,0 +1,50 @@
+#ifndef _FRONTIER_SEARCH_H
+#define _FRONTIER_SEARCH_H
+
+#include <cstddef>
+#include <vector>
+#include "objects.h"
+
+using namespace std;
+
+class Deadline;
+
+// Shortest route search whose state is bounded, for huge grids (breadth-first frontier search
+// with divide-and-conquer path recovery, after Korf et al.). Only the search state is bounded:
+// the Grid it reads still holds a Cell per cell.
+//
+// Two BFS frontiers grow from both ends, one layer at a time. In a grid the neighbours of a
+// layer lie in the layer itself or the ones next to it, so only the last two layers of each
+// side are kept, as sorted cell lists, and nothing is written to the cells. Where the new
+// layer of one side meets the other side's frontier lies a cell m halfway along a shortest
+// route; the route is then recovered by searching start..m and m..end the same way.
+// The time grows by a factor of about log2(route length).
+class FrontierSearch {
+public:
+    static const int OVER_CAP = -3;  // search() result when the frontiers outgrew the cap
+
+    // cap: bytes the frontier layers may take, 0 for no limit
+    explicit FrontierSearch(size_t cap) : cap(cap) {}
+
+    // Shortest route of net `rid` from `start` to `end`, appended to `route` as linear cell
+    // indices (x * N + y) from start to end. Returns 1 if found, 0 if there is no route,
+    // NOT_ATTEMPTED if `deadline` expired first and OVER_CAP if the cap was hit.
+    int search(const Grid& g, int rid, int start, int end, const Deadline* deadline, vector<int>& route);
+
+    size_t cap;
+    size_t peak_bytes = 0;   // largest search state of all searches so far, never above the cap
+
+private:
+    // Distance between a and b with a cell halfway, or -1 (no route) / status codes
+    int meet(int a, int b, int& mid, int& dist_a);
+    int recover(int a, int b, int dist, vector<int>& route);
+    bool open(int c) const;
+    bool expand(const vector<int>& prev, const vector<int>& cur, vector<int>& next, size_t room) const;
+
+    const Grid* g = nullptr;
+    int rid = -1, from = -1, to = -1;   // from/to: end points of the current sub-search
+    const Deadline* deadline = nullptr;
+    long long expansions = 0;
+};
+
+#endif
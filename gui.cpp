@@ -0,0 +1,224 @@
+#include <iostream>
+#include <thread>
+#include "gui.h"
+#include "draw.h"
+#include "snapshot.h"
+#include "trace.h"
+
+using namespace std;
+
+// Defined in draw.cpp
+extern map<int, int> id_to_steps;
+
+// Interactive editing state once routing has finished
+struct EditState {
+    Cell* picked = nullptr;     // end point picked up with a left click, dropped with the next one
+    Cell* new_start = nullptr;  // start of a net being placed with right clicks
+};
+
+// Left click : toggle an obstacle, or pick up an end point and drop it on a free cell
+// Right click: remove the net of an end point, or place a new net (first click S, second click E)
+bool handleMazeClick(Grid& g, Router& r, EditState& st, int row, int col, bool left, SearchMode mode){
+    Cell& c = g.grid[row][col];
+    Edit e;
+
+    if (left) {
+        if (st.picked) {
+            e.type = st.picked->is_start ? Edit::MOVE_START : Edit::MOVE_END;
+            e.net_id = st.picked->path_id;
+            st.picked = nullptr;
+        }
+        else if (c.is_start || c.is_end) {
+            st.picked = &c;
+            return false;
+        }
+        else {
+            e.type = c.is_obstacle ? Edit::REMOVE_OBSTACLE : Edit::ADD_OBSTACLE;
+        }
+        e.x = row, e.y = col;
+    }
+    else {
+        if (c.is_start || c.is_end) {
+            e.type = Edit::REMOVE_NET;
+            e.net_id = c.path_id;
+            st.new_start = nullptr;
+        }
+        else if (!c.is_space) {
+            return false;
+        }
+        else if (!st.new_start) {
+            st.new_start = &c;
+            return false;
+        }
+        else {
+            int next_id = 1;
+            for (const auto& [id, _] : g.net_points) next_id = max(next_id, id + 1);
+            e.type = Edit::ADD_NET;
+            e.net_id = next_id;
+            e.x = st.new_start->x, e.y = st.new_start->y;
+            e.x2 = row, e.y2 = col;
+            st.new_start = nullptr;
+        }
+    }
+    return r.apply_edit(g, e, id_to_steps, mode);
+}
+
+string windowTitle(const RouteFrame& frame, int total_routes){
+    string title = "Maze Routing - " + std::to_string(frame.routed) + "/" + std::to_string(total_routes);
+    return title + (frame.done ? " routes found!" : " routes found, routing...");
+}
+
+// Window fitting the maze in 2/3 of the screen, with the button panel below it
+bool openWindow(const Grid& g, sf::RenderWindow& window, int& cellSize, float& PanelHeightRate, bool enable_print){
+    if(enable_print)
+        cout << "Initializing GUI..." << endl;
+    // Building SFML window
+    // -> user's screen size
+    sf::VideoMode desktop = sf::VideoMode::getDesktopMode();
+    int screenW = desktop.width;
+    int screenH = desktop.height;
+    // -> control windows size
+    cellSize = max(min((screenW * 2/3) / g.N, (screenH * 2/3) / g.M), 4);
+    int windowWidth = g.N * cellSize;
+    int windowHeight = g.M * cellSize;
+    int buttonPanelHeight = 100;
+    PanelHeightRate = (float) buttonPanelHeight / (float) (buttonPanelHeight + windowHeight);
+
+    if(enable_print)
+        cout << "Creating window with size: " << windowWidth << "x" << (windowHeight + buttonPanelHeight) << endl;
+
+    window.create(sf::VideoMode(windowWidth, windowHeight + buttonPanelHeight), "Maze Routing");
+    if (!window.isOpen()) {
+        cout << "Failed to create window!" << endl;
+        return false;
+    }
+    window.setFramerateLimit(60);
+    return true;
+}
+
+int runGui(Grid& g, Router& r, const function<map<int,int>()>& run_routing, SearchMode mode, bool enable_print){
+    // Routing runs on a worker thread and publishes its progress through `snapshot`,
+    // so the window comes up as soon as the maze is parsed.
+    RouteSnapshot snapshot;
+    snapshot.init(g);
+    r.snapshot = &snapshot;
+    thread worker([&]() {
+        snapshot.finish(run_routing());
+    });
+
+    try {
+        sf::RenderWindow window;
+        int cellSize;
+        float PanelHeightRate;
+        if (!openWindow(g, window, cellSize, PanelHeightRate, enable_print)) {
+            snapshot.cancel();
+            worker.join();
+            return 1;
+        }
+
+        // Initialize SFML Window with the unrouted maze
+        int total_routes = g.net_points.size();
+        RouteFrame frame;
+        EditState edit_state;
+        snapshot.acquire(frame);
+        window.setTitle(windowTitle(frame, total_routes));
+        window.clear();
+        renderMaze(g, frame.owner, window, cellSize);
+        window.display();
+       
+        if(enable_print)
+            cout << "Window created successfully. Starting main loop..." << endl;
+        
+        // Main Loop        
+        while (window.isOpen()) {
+            sf::Event event;
+            while (window.pollEvent(event)) {
+                if (event.type == sf::Event::Closed)
+                    window.close();
+                else if (event.type == sf::Event::MouseButtonPressed) {
+                    // Convert mouse position to world coordinates
+                    sf::Vector2f worldPos = window.mapPixelToCoords(
+                        sf::Vector2i(event.mouseButton.x, event.mouseButton.y)
+                    );
+                    bool left = event.mouseButton.button == sf::Mouse::Left;
+                    // Handle button clicks
+                    if (left && handleButtonClick(worldPos, window, PanelHeightRate))
+                        continue;
+
+                    // Maze edits are only accepted once the routing thread is done with the grid
+                    int row = static_cast<int>(worldPos.y / cellSize);
+                    int col = static_cast<int>(worldPos.x / cellSize);
+                    if (frame.done && worldPos.x >= 0 && worldPos.y >= 0 && row < g.M && col < g.N &&
+                        (left || event.mouseButton.button == sf::Mouse::Right)) {
+                        handleMazeClick(g, r, edit_state, row, col, left, mode);
+                    }
+                }          
+            }
+
+            // Pick up the routes committed since the last frame
+            if (snapshot.acquire(frame)) {
+                id_to_steps = frame.id_to_steps;
+                window.setTitle(windowTitle(frame, total_routes));
+            }
+
+            TraceSpan span("frame");
+            window.clear();
+            renderMaze(g, frame.owner, window, cellSize);
+            window.display();
+        }
+    } 
+    catch (const std::exception& e) {
+        cout << "Error creating window: " << e.what() << endl;
+        snapshot.cancel();
+        worker.join();
+        return 1;
+    }
+
+    // Stop routing early if the window was closed before it finished
+    snapshot.cancel();
+    worker.join();
+    return 0;
+}
+
+int viewGui(const Grid& g, const map<int,int>& steps, bool enable_print){
+    id_to_steps = steps;
+    vector<int> owner((size_t)g.M * g.N);
+    for (int i = 0; i < g.M; ++i)
+        for (int j = 0; j < g.N; ++j)
+            owner[(size_t)i * g.N + j] = g.grid[i][j].path_id;
+    int routed = 0;
+    for (const auto& [id, s] : steps)
+        if (s > 0) routed++;
+
+    try {
+        sf::RenderWindow window;
+        int cellSize;
+        float PanelHeightRate;
+        if (!openWindow(g, window, cellSize, PanelHeightRate, enable_print))
+            return 1;
+        window.setTitle("Maze Routing - " + std::to_string(routed) + "/" + std::to_string(g.net_points.size()) + " routes (saved result)");
+
+        while (window.isOpen()) {
+            sf::Event event;
+            while (window.pollEvent(event)) {
+                if (event.type == sf::Event::Closed)
+                    window.close();
+                else if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
+                    sf::Vector2f worldPos = window.mapPixelToCoords(
+                        sf::Vector2i(event.mouseButton.x, event.mouseButton.y)
+                    );
+                    handleButtonClick(worldPos, window, PanelHeightRate);
+                }
+            }
+            TraceSpan span("frame");
+            window.clear();
+            renderMaze(g, owner, window, cellSize);
+            window.display();
+        }
+    }
+    catch (const std::exception& e) {
+        cout << "Error creating window: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,16 @@
+#ifndef _GUI_H
+#define _GUI_H
+
+#include <functional>
+#include <map>
+#include "objects.h"
+
+using namespace std;
+
+// Opens the maze window while `run_routing` runs on a worker thread, then lets the user
+// edit the routed maze until the window is closed. Returns the process exit code.
+int runGui(Grid& g, Router& r, const function<map<int,int>()>& run_routing, SearchMode mode, bool enable_print);
+// Only shows `g` as it is routed (see --view): no routing and no edits
+int viewGui(const Grid& g, const map<int,int>& steps, bool enable_print);
+
+#endif
@@ -1,32 +1,38 @@
 #include "ilp_solver.h"
 #include "path.h"
+#include "trace.h"
 #include <algorithm>
+#include <cmath>
 #include <map>
 
 void ILPSolver::build_model(GRBModel& model,
-                          const std::vector<Path>& all_paths,
+                          const PathPool& all_paths,
+                          const std::vector<int>& members,
+                          const std::vector<CutConstraint>& cuts,
                           std::vector<GRBVar>& y_vars,
-                          std::map<std::pair<int, int>, std::vector<std::pair<GRBVar, int>>>& x_vars) {
+                          std::unordered_map<int, std::vector<std::pair<GRBVar, int>>>& x_vars) {
+    TraceSpan span("build_model", "paths", members.size());
     try {
         // cout << "Building ILP model..." << endl;
 
 
         // 創建路徑選擇變數 y_p
         // cout << "Creating path selection variables..." << endl;
-        y_vars.resize(all_paths.size());  // 預先分配空間
-        for (size_t i = 0; i < all_paths.size(); ++i) {
-            y_vars[i] = model.addVar(0.0, 1.0, 1.0, GRB_BINARY, "y_" + std::to_string(all_paths[i].net_id));
+        y_vars.resize(members.size());  // 預先分配空間
+        for (size_t i = 0; i < members.size(); ++i) {
+            y_vars[i] = model.addVar(0.0, 1.0, 1.0, GRB_BINARY, "y_" + std::to_string(all_paths[members[i]].net_id));
         }
         // cout << "Created " << y_vars.size() << " path selection variables" << endl;
 
         // 創建格子使用變數 x_{ij,p}
         // cout << "Creating cell usage variables..." << endl;
-        for (size_t p = 0; p < all_paths.size(); ++p) {
-            // cout << "Processing path " << p << " (net_id: " << all_paths[p].net_id << ") with " << all_paths[p].cells.size() << " cells" << endl;
-            for (const auto& cell : all_paths[p].cells) {
-                x_vars[cell].push_back({model.addVar(0.0, 1.0, 0.0, GRB_BINARY, 
-                    "x_" + std::to_string(cell.first) + "_" + std::to_string(cell.second) + "_" + std::to_string(all_paths[p].net_id)),
-                    all_paths[p].net_id});
+        for (size_t p = 0; p < members.size(); ++p) {
+            PathView path = all_paths[members[p]];
+            // cout << "Processing path " << p << " (net_id: " << path.net_id << ") with " << path.size() << " cells" << endl;
+            for (int k = 0; k < path.size(); ++k) {
+                x_vars[path[k]].push_back({model.addVar(0.0, 1.0, 0.0, GRB_BINARY, 
+                    "x_" + std::to_string(path.x(k)) + "_" + std::to_string(path.y(k)) + "_" + std::to_string(path.net_id)),
+                    path.net_id});
             }
         }
         // cout << "Created cell usage variables" << endl;
@@ -34,11 +40,12 @@ void ILPSolver::build_model(GRBModel& model,
         // 添加限制式：同一條路徑上的點必須一起被選中或一起不被選中
         // cout << "Adding path consistency constraints..." << endl;
         int constraint_count = 0;
-        for (size_t p = 0; p < all_paths.size(); ++p) {
-            // cout << "Adding constraints for path " << p << " (net_id: " << all_paths[p].net_id << ")" << endl;
-            for (const auto& cell : all_paths[p].cells) {
+        for (size_t p = 0; p < members.size(); ++p) {
+            PathView path = all_paths[members[p]];
+            // cout << "Adding constraints for path " << p << " (net_id: " << path.net_id << ")" << endl;
+            for (int cell : path) {
                 for(const auto& [var, net_id] : x_vars[cell]){
-                    if(net_id == all_paths[p].net_id){
+                    if(net_id == path.net_id){
                         model.addConstr(var == y_vars[p]);
                         constraint_count++;
                     }
@@ -52,7 +59,7 @@ void ILPSolver::build_model(GRBModel& model,
         constraint_count = 0;
         for (const auto& [cell, vars] : x_vars) {
             try {
-                // cout << "Adding cell usage constraint for cell (" << cell.first << "," << cell.second << ")" << endl;
+                // cout << "Adding cell usage constraint for cell (" << cell / all_paths.stride() << "," << cell % all_paths.stride() << ")" << endl;
                 GRBLinExpr sum;
                 for (const auto& [var, net_id] : vars) {
                     sum += var;
@@ -63,12 +70,22 @@ void ILPSolver::build_model(GRBModel& model,
             } 
             catch (const std::exception& e) {
                 cout << "Error adding cell usage constraint for cell (" 
-                     << cell.first << "," << cell.second << "): " << e.what() << endl;
+                     << cell / all_paths.stride() << "," << cell % all_paths.stride() << "): " << e.what() << endl;
                 throw;
             }
         }
         // cout << "Added " << constraint_count << " cell usage constraints" << endl;
 
+        // 添加限制式：通過同一個割集的路徑最多 limit 條 (limit 1 is already a cell usage constraint)
+        for (const CutConstraint& cut : cuts) {
+            if (cut.limit < 2) continue;
+            GRBLinExpr sum;
+            for (int i : cut.members) {
+                sum += y_vars[i];
+            }
+            model.addConstr(sum <= cut.limit);
+        }
+
         // 設置目標函數：最大化選中的路徑數量
         // cout << "Setting objective function..." << endl;
         GRBLinExpr objective;
@@ -86,36 +103,58 @@ void ILPSolver::build_model(GRBModel& model,
     }
 }
 
-std::vector<Path> ILPSolver::solve(const std::vector<Path>& all_paths) {
-    try {
+void ILPSolver::prepare(int workers, int threads) {
+    if ((int)envs.size() < workers) envs.resize(workers);
+    thread_count = threads;
+}
+
+// The environment of a worker is created once and reused for every component it solves
+GRBEnv& ILPSolver::env(int worker) {
+    std::unique_ptr<GRBEnv>& env = envs[worker];
+    if (!env) {
         // cout << "Initializing Gurobi environment..." << endl;
-        GRBEnv env = GRBEnv();
-        
-        // 設置求解器參數
-        env.set(GRB_IntParam_OutputFlag, 0);  // 0: 不顯示求解過程
-        env.set(GRB_DoubleParam_TimeLimit, time_limit);  // 設置時間限制
-        env.set(GRB_IntParam_Threads, thread_count);  // 設置執行緒數量
-        
+        env = std::make_unique<GRBEnv>();
+        env->set(GRB_IntParam_OutputFlag, 0);  // 0: 不顯示求解過程
+    }
+    return *env;
+}
+
+std::vector<int> ILPSolver::solve(const PathPool& all_paths, const std::vector<int>& members,
+                                  const std::vector<CutConstraint>& cuts, double time_limit, int worker) {
+    // 割集上界已證明貪婪解為最佳解時不必建模
+    if (!cuts.empty()) {
+        std::vector<int> greedy = greedy_disjoint(all_paths, members);
+        if ((int)greedy.size() >= cut_bound(members.size(), cuts)) return greedy;
+    }
+
+    try {
         // cout << "Creating model..." << endl;
-        GRBModel model = GRBModel(env);
+        GRBModel model = GRBModel(env(worker));
+
+        // 設置求解器參數
+        model.set(GRB_DoubleParam_TimeLimit, time_limit);  // 設置時間限制 (remaining share of the global limit)
+        model.set(GRB_IntParam_Threads, thread_count);  // 設置執行緒數量
         
         std::vector<GRBVar> y_vars;
-        std::map<std::pair<int, int>, std::vector<std::pair<GRBVar, int>>> x_vars;
+        std::unordered_map<int, std::vector<std::pair<GRBVar, int>>> x_vars;
         
-        build_model(model, all_paths, y_vars, x_vars);
+        build_model(model, all_paths, members, cuts, y_vars, x_vars);
         
         // cout << "Optimizing model..." << endl;
-        model.optimize();
+        {
+            TraceSpan span("optimize", "paths", members.size());
+            model.optimize();
+        }
         
         int status = model.get(GRB_IntAttr_Status);
         // cout << "Optimization status: " << status << endl;
         
-        if (status == GRB_OPTIMAL || status == GRB_TIME_LIMIT) {
+        if ((status == GRB_OPTIMAL || status == GRB_TIME_LIMIT) && model.get(GRB_IntAttr_SolCount) > 0) {
             // 收集結果
-            std::vector<Path> selected_paths;
-            for (size_t i = 0; i < all_paths.size(); ++i) {
+            std::vector<int> selected_paths;
+            for (size_t i = 0; i < members.size(); ++i) {
                 if (y_vars[i].get(GRB_DoubleAttr_X) > 0.5) {
-                    selected_paths.push_back(all_paths[i]);
+                    selected_paths.push_back(members[i]);
                 }
             }
             // cout << "Found " << selected_paths.size() << " non-conflicting paths" << endl;
@@ -136,4 +175,82 @@ std::vector<Path> ILPSolver::solve(const std::vector<Path>& all_paths) {
         std::cerr << "Unexpected error: " << e.what() << std::endl;
         return {};
     }
-} 
\ No newline at end of file
+} 
+
+namespace {
+
+// Trades solutions with the other solvers of a portfolio race while Gurobi runs
+class RaceCallback : public GRBCallback {
+public:
+    RaceCallback(SharedIncumbent& shared, const std::vector<int>& members, std::vector<GRBVar>& y_vars)
+        : shared(shared), members(members), y_vars(y_vars) {}
+
+protected:
+    void callback() override {
+        if (where == GRB_CB_MIP) {
+            // 上界已不高於共享解：共享解即為最佳解
+            shared.tighten((int)std::floor(getDoubleInfo(GRB_CB_MIP_OBJBND) + 1e-6));
+            if (shared.stopped()) abort();
+        }
+        else if (where == GRB_CB_MIPSOL) {
+            std::vector<int> chosen;
+            for (size_t i = 0; i < members.size(); ++i)
+                if (getSolution(y_vars[i]) > 0.5) chosen.push_back(members[i]);
+            shared.offer(chosen, SharedIncumbent::EXACT);
+        }
+        else if (where == GRB_CB_MIPNODE && shared.size() > getDoubleInfo(GRB_CB_MIPNODE_OBJBST) + 0.5) {
+            // A better heuristic answer becomes Gurobi's incumbent (the x variables follow y)
+            std::vector<int> best = shared.best();
+            std::vector<double> values(members.size(), 0.0);
+            for (size_t i = 0, k = 0; i < members.size() && k < best.size(); ++i)
+                if (members[i] == best[k]) values[i] = 1.0, k++;
+            setSolution(y_vars.data(), values.data(), members.size());
+            useSolution();
+        }
+    }
+
+private:
+    SharedIncumbent& shared;
+    const std::vector<int>& members;
+    std::vector<GRBVar>& y_vars;
+};
+
+}
+
+bool ILPSolver::race(const PathPool& all_paths, const std::vector<int>& members, const std::vector<CutConstraint>& cuts,
+                     double time_limit, int worker, SharedIncumbent& shared) {
+    try {
+        GRBModel model = GRBModel(env(worker));
+        model.set(GRB_DoubleParam_TimeLimit, time_limit);
+        model.set(GRB_IntParam_Threads, thread_count);
+
+        std::vector<GRBVar> y_vars;
+        std::unordered_map<int, std::vector<std::pair<GRBVar, int>>> x_vars;
+        build_model(model, all_paths, members, cuts, y_vars, x_vars);
+
+        // MIP start: the best answer so far
+        std::vector<int> best = shared.best();
+        for (size_t i = 0, k = 0; i < members.size(); ++i) {
+            bool chosen = k < best.size() && members[i] == best[k];
+            if (chosen) k++;
+            y_vars[i].set(GRB_DoubleAttr_Start, chosen ? 1.0 : 0.0);
+        }
+
+        RaceCallback callback(shared, members, y_vars);
+        model.setCallback(&callback);
+        {
+            TraceSpan span("optimize", "paths", members.size());
+            model.optimize();
+        }
+        if (model.get(GRB_IntAttr_Status) == GRB_OPTIMAL) {
+            shared.tighten(std::lround(model.get(GRB_DoubleAttr_ObjVal)));
+            return true;
+        }
+        return shared.proven();
+    }
+    catch (GRBException& e) {
+        std::cerr << "Error in ILP solver: " << e.getErrorCode() << std::endl;
+        std::cerr << e.getMessage() << std::endl;
+        return false;
+    }
+}
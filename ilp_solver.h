@@ -4,29 +4,39 @@
 #include <vector>
 #include <map>
 #include <set>
+#include <unordered_map>
+#include <memory>
 #include <gurobi_c++.h>
 #include "objects.h"
 #include "path.h"
+#include "conflict_solver.h"
 
-class ILPSolver {
+// Gurobi model of one conflict component; each worker thread keeps its own GRBEnv
+class ILPSolver : public ComponentSolver {
 public:
-    // 輸入所有可能的路徑，返回最佳的不衝突路徑集合
-    std::vector<Path> solve(const std::vector<Path>& all_paths);
-
-    // Set solver parameters
-    void set_time_limit(double seconds) { time_limit = seconds; }
-    void set_thread_count(int count) { thread_count = count; }
+    void prepare(int workers, int threads) override;
+    // 輸入一個衝突元件中所有可能的路徑，返回最佳的不衝突路徑集合 (subset of members)
+    std::vector<int> solve(const PathPool& all_paths, const std::vector<int>& members,
+                           const std::vector<CutConstraint>& cuts, double time_limit, int worker) override;
+    // Starts from the shared best (MIP start), takes the other solvers' improvements as
+    // incumbents and stops once the shared best meets Gurobi's bound (see portfolio.h)
+    bool race(const PathPool& all_paths, const std::vector<int>& members, const std::vector<CutConstraint>& cuts,
+              double time_limit, int worker, SharedIncumbent& shared) override;
 
 private:    
     // Building ILP Model
     void build_model(GRBModel& model, 
-                    const std::vector<Path>& all_paths,
+                    const PathPool& all_paths,
+                    const std::vector<int>& members,
+                    const std::vector<CutConstraint>& cuts,  // 割集基數限制 (cut_analysis.h)
                     std::vector<GRBVar>& y_vars,  // 路徑選擇變數
-                    std::map<std::pair<int, int>, std::vector<std::pair<GRBVar, int>>>& x_vars);  // 格子使用變數
+                    std::unordered_map<int, std::vector<std::pair<GRBVar, int>>>& x_vars);  // 格子使用變數 (keyed by linear cell index)
+
+    GRBEnv& env(int worker);
 
-    // Solver parameters
-    double time_limit = 30.0;
+    // Gurobi threads per component model, set by prepare()
     int thread_count = 1;
+    std::vector<std::unique_ptr<GRBEnv>> envs;
 };
 
 #endif 
\ No newline at end of file
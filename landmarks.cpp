@@ -0,0 +1,113 @@
+#include "landmarks.h"
+#include "trace.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+
+using namespace std;
+
+// Plain BFS over the non-obstacle cells; returns the distance of every cell from `source`
+static vector<int> bfs_distances(const Grid& g, int source){
+    int dx[4] = {1, -1, 0, 0};
+    int dy[4] = {0, 0, 1, -1};
+    vector<int> d((size_t)g.M * g.N, -1);
+    vector<int> queue;
+    queue.reserve(d.size());
+    queue.push_back(source);
+    d[source] = 0;
+    for (size_t head = 0; head < queue.size(); ++head) {
+        int cur = queue[head];
+        int x = cur / g.N, y = cur % g.N;
+        for (int dir = 0; dir < 4; ++dir) {
+            int nx = x + dx[dir], ny = y + dy[dir];
+            if (nx < 0 || nx >= g.M || ny < 0 || ny >= g.N || g.grid[nx][ny].is_obstacle) continue;
+            int next = nx * g.N + ny;
+            if (d[next] != -1) continue;
+            d[next] = d[cur] + 1;
+            queue.push_back(next);
+        }
+    }
+    return d;
+}
+
+// Landmarks go to the free cells closest to points spread evenly along the border, all in the
+// largest open region (a landmark walled off from the rest says nothing about it)
+void Landmarks::select(const Grid& g, int count){
+    int dx[4] = {1, -1, 0, 0};
+    int dy[4] = {0, 0, 1, -1};
+    int total = g.M * g.N;
+    vector<int> region(total, -1), stack;
+    int best_region = -1, best_size = 0, regions = 0;
+    for (int c = 0; c < total; ++c) {
+        if (region[c] != -1 || g.grid[c / g.N][c % g.N].is_obstacle) continue;
+        int size = 0;
+        region[c] = regions;
+        stack.push_back(c);
+        while (!stack.empty()) {
+            int cur = stack.back();
+            stack.pop_back();
+            size++;
+            for (int dir = 0; dir < 4; ++dir) {
+                int nx = cur / g.N + dx[dir], ny = cur % g.N + dy[dir];
+                if (nx < 0 || nx >= g.M || ny < 0 || ny >= g.N || g.grid[nx][ny].is_obstacle) continue;
+                if (region[nx * g.N + ny] != -1) continue;
+                region[nx * g.N + ny] = regions;
+                stack.push_back(nx * g.N + ny);
+            }
+        }
+        if (size > best_size) best_size = size, best_region = regions;
+        regions++;
+    }
+    if (best_region == -1) return;
+
+    int perimeter = max(1, 2 * (g.M - 1) + 2 * (g.N - 1));
+    for (int k = 0; k < count && (int)cells.size() < best_size; ++k) {
+        // walk clockwise from the top-left corner
+        int p = (long long)k * perimeter / count, px, py;
+        if (p < g.N - 1) px = 0, py = p;
+        else if ((p -= g.N - 1) < g.M - 1) px = p, py = g.N - 1;
+        else if ((p -= g.M - 1) < g.N - 1) px = g.M - 1, py = g.N - 1 - p;
+        else px = g.M - 1 - (p - (g.N - 1)), py = 0;
+
+        int pick = -1, pick_distance = 0;
+        for (int c = 0; c < total; ++c) {
+            if (region[c] != best_region || find(cells.begin(), cells.end(), c) != cells.end()) continue;
+            int distance = abs(c / g.N - px) + abs(c % g.N - py);
+            if (pick == -1 || distance < pick_distance) pick = c, pick_distance = distance;
+        }
+        cells.push_back(pick);
+    }
+}
+
+void Landmarks::build(const Grid& g, int count, int threads){
+    TraceSpan span("landmarks", "count", count);
+    landmark_count = count;
+    thread_count = max(1, threads);
+    cells.clear();
+    dist.clear();
+    if (count <= 0 || g.M == 0 || g.N == 0) return;
+    select(g, count);
+    if (cells.empty()) return;
+
+    // One field per landmark, computed in parallel, then interleaved per cell
+    int K = cells.size();
+    vector<vector<int>> fields(K);
+    atomic<int> next{0};
+    auto work = [&]() {
+        for (int k; (k = next++) < K;)
+            fields[k] = bfs_distances(g, cells[k]);
+    };
+    vector<thread> pool;
+    for (int t = 1; t < min(thread_count, K); ++t) pool.emplace_back(work);
+    work();
+    for (auto& t : pool) t.join();
+
+    size_t total = (size_t)g.M * g.N;
+    dist.assign(total * K, UNKNOWN);
+    for (size_t c = 0; c < total; ++c)
+        for (int k = 0; k < K; ++k) {
+            int d = fields[k][c];
+            if (d >= 0 && d < UNKNOWN) dist[c * K + k] = d;
+        }
+}
@@ -0,0 +1,51 @@
+#ifndef _LANDMARKS_H
+#define _LANDMARKS_H
+
+#include <cstdint>
+#include <vector>
+#include "objects.h"
+
+using namespace std;
+
+// ALT (A*, landmarks, triangle inequality) lower bounds for Router::astar.
+//
+// BFS distance fields are computed from a few landmark cells spread around the border of the
+// maze. Only the static obstacles count as walls: routed nets and end points can only make
+// real paths longer, so |d(L, t) - d(L, n)| stays a lower bound on the distance from n to t
+// while nets are being routed. Removing an obstacle can shorten paths, so the fields must be
+// rebuilt after that (Router::apply_edit does).
+class Landmarks {
+public:
+    static constexpr uint16_t UNKNOWN = 0xffff;  // unreachable, or too far for 16 bits
+
+    // Picks `count` landmarks and computes their fields on up to `threads` threads
+    void build(const Grid& g, int count, int threads = 1);
+    void rebuild(const Grid& g) { build(g, landmark_count, thread_count); }
+
+    bool empty() const { return cells.empty(); }
+    int size() const { return cells.size(); }
+    const vector<int>& landmark_cells() const { return cells; }  // linear indices x * N + y
+
+    // Lower bound on the path length between two cells (linear indices), 0 if unknown
+    int lower_bound(int from, int to) const {
+        const uint16_t* a = &dist[(size_t)from * cells.size()];
+        const uint16_t* b = &dist[(size_t)to * cells.size()];
+        int best = 0;
+        for (size_t k = 0; k < cells.size(); ++k) {
+            if (a[k] == UNKNOWN || b[k] == UNKNOWN) continue;
+            int d = a[k] > b[k] ? a[k] - b[k] : b[k] - a[k];
+            if (d > best) best = d;
+        }
+        return best;
+    }
+
+private:
+    void select(const Grid& g, int count);
+
+    int landmark_count = 0, thread_count = 1;
+    vector<int> cells;
+    // dist[cell * size() + k]: distance from landmark k, all landmarks of a cell side by side
+    vector<uint16_t> dist;
+};
+
+#endif
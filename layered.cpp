@@ -0,0 +1,279 @@
+#include "layered.h"
+#include "deadline.h"
+#include "objects.h"
+#include "result_io.h"
+#include "trace.h"
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+// Direction codes, in the order of the result format: U, D, L, R, +, -
+static const int DX[6] = {-1, 1, 0, 0, 0, 0};
+static const int DY[6] = {0, 0, -1, 1, 0, 0};
+static const int DL[6] = {0, 0, 0, 0, 1, -1};
+static const char DIRS[] = "UDLR+-";
+
+bool is_layered_maze(const string& filename){
+    ifstream input(filename);
+    string line;
+    if (!getline(input, line)) return false;
+    istringstream ss(line);
+    int numbers = 0;
+    long long v;
+    while (ss >> v) numbers++;
+    return numbers >= 4;
+}
+
+namespace {
+
+struct Scanner {
+    const char* p;
+    const char* end;
+
+    void skip_space(){
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) ++p;
+    }
+    // Next whitespace-separated token as [begin, end)
+    bool token(const char*& b, const char*& e){
+        skip_space();
+        b = p;
+        while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') ++p;
+        e = p;
+        return b != e;
+    }
+    bool integer(int& v){
+        const char *b, *e;
+        return token(b, e) && from_chars(b, e, v).ptr == e;
+    }
+};
+
+}
+
+bool parse_layered_maze(const char* data, size_t size, LayeredGrid& g, string& error){
+    Scanner s{data, data + size};
+
+    // Header: the optional wrong-way cost is whatever comes before the end of the first line
+    const char* eol = find(data, data + size, '\n');
+    int m, n, l, via;
+    if (!s.integer(m) || !s.integer(n) || !s.integer(l) || !s.integer(via) || m <= 0 || n <= 0 || l <= 0 || via < 0) {
+        error = "Invalid layered maze header!";
+        return false;
+    }
+    if ((long long)m * n * l > INT_MAX) {
+        error = "Layered maze too large!";
+        return false;
+    }
+    g = LayeredGrid();
+    g.M = m, g.N = n, g.L = l;
+    g.via_cost = via;
+    s.skip_space();
+    if (s.p < eol && (!s.integer(g.wrong_way_cost) || g.wrong_way_cost < 1)) {
+        error = "Invalid wrong-way cost!";
+        return false;
+    }
+    g.preferred.assign(l, '*');
+    g.owner.assign((size_t)m * n * l, LayeredGrid::FREE);
+
+    map<int, pair<int, int>> points;
+    const char *b, *e;
+    for (int k = 0; k < l; ++k) {
+        if (!s.token(b, e) || e - b != 1 || (*b != 'H' && *b != 'V' && *b != '*')) {
+            error = "Missing direction (H, V or *) of layer " + to_string(k) + "!";
+            return false;
+        }
+        g.preferred[k] = *b;
+
+        for (int i = 0; i < m; ++i) {
+            for (int j = 0; j < n; ++j) {
+                if (!s.token(b, e)) {
+                    error = "Unexpected end of maze input!";
+                    return false;
+                }
+                int cell = g.index(k, i, j);
+                if (e - b == 1 && *b == '.') continue;
+                if (e - b == 1 && *b == '#') {
+                    g.owner[cell] = LayeredGrid::OBSTACLE;
+                    continue;
+                }
+                int id;
+                if ((*b == 'S' || *b == 'E') && e - b >= 2 && e - b <= 10 && from_chars(b + 1, e, id).ptr == e && id >= 0) {
+                    auto it = points.try_emplace(id, -1, -1).first;
+                    (*b == 'S' ? it->second.first : it->second.second) = cell;
+                    g.owner[cell] = id;
+                    continue;
+                }
+                error = "Invalid token in input: " + string(b, e);
+                return false;
+            }
+        }
+    }
+
+    for (const auto& [id, pair] : points) {
+        if (pair.first == -1 || pair.second == -1) {
+            error = "Missing S" + to_string(id) + " or E" + to_string(id) + "!";
+            return false;
+        }
+    }
+    g.net_points = move(points);
+    return true;
+}
+
+LayeredGrid read_layered_maze(const string& filename){
+    TraceSpan span("read_layered_maze");
+    FILE* in = fopen(filename.c_str(), "rb");
+    if (!in) {
+        cout << "Cannot read the input file!\n";
+        exit(1);
+    }
+    fseek(in, 0, SEEK_END);
+    long size = ftell(in);
+    fseek(in, 0, SEEK_SET);
+    vector<char> data(size > 0 ? size : 0);
+    bool ok = size >= 0 && fread(data.data(), 1, data.size(), in) == data.size();
+    fclose(in);
+
+    LayeredGrid g;
+    string error = "Cannot read the input file!";
+    if (!ok || !parse_layered_maze(data.data(), data.size(), g, error)) {
+        cout << error << endl;
+        exit(1);
+    }
+    return g;
+}
+
+map<int,int> LayeredRouter::route(LayeredGrid& g, bool use_astar){
+    map<int,int> id_to_steps;
+    costs.clear();
+    vias.clear();
+    dist.assign(g.owner.size(), INT_MAX);
+    from.assign(g.owner.size(), 0);
+    touched.clear();
+    expansions = 0;
+
+    for (const auto& [id, points] : g.net_points) {
+        if (deadline && deadline->expired()) {
+            id_to_steps[id] = NOT_ATTEMPTED;
+            continue;
+        }
+        TraceSpan span(use_astar ? "layered_astar" : "layered_bfs", "net", id);
+        id_to_steps[id] = search(g, id, use_astar);
+    }
+    return id_to_steps;
+}
+
+// Least-cost search with a bucket queue: all costs are small integers, so the open list is
+// a ring of 2 * (largest step cost) + 1 buckets indexed by f = cost + heuristic
+int LayeredRouter::search(LayeredGrid& g, int rid, bool use_astar){
+    const int start = g.net_points[rid].first, target = g.net_points[rid].second;
+    const int tl = g.layer(target), tx = g.row(target), ty = g.col(target);
+    const int offset[6] = {-g.N * g.L, g.N * g.L, -g.L, g.L, 1, -1};
+    const int max_step = max({1, g.via_cost, g.wrong_way_cost});
+    const int B = 2 * max_step + 1;
+    buckets.resize(B);
+
+    auto h = [&](int l, int x, int y) {
+        return use_astar ? abs(x - tx) + abs(y - ty) + abs(l - tl) * g.via_cost : 0;
+    };
+
+    dist[start] = 0;
+    touched.push_back(start);
+    int f = h(g.layer(start), g.row(start), g.col(start));
+    buckets[f % B].push_back(start);
+    long long pending = 1;
+    bool found = false, timed_out = false;
+
+    while (pending > 0) {
+        vector<int>& bucket = buckets[f % B];
+        if (bucket.empty()) {
+            f++;
+            continue;
+        }
+        int cur = bucket.back();
+        bucket.pop_back();
+        pending--;
+        int l = g.layer(cur), x = g.row(cur), y = g.col(cur);
+        if (dist[cur] + h(l, x, y) != f) continue;  // stale entry, reached cheaper since
+        if (cur == target) {
+            found = true;
+            break;
+        }
+        if (deadline && (++expansions & 4095) == 0 && deadline->expired()) {
+            timed_out = true;
+            break;
+        }
+
+        char pref = g.preferred[l];
+        for (int dir = 0; dir < 6; ++dir) {
+            int nl = l + DL[dir], nx = x + DX[dir], ny = y + DY[dir];
+            if (nl < 0 || nl >= g.L || nx < 0 || nx >= g.M || ny < 0 || ny >= g.N) continue;
+            int next = cur + offset[dir];
+            if (g.owner[next] != LayeredGrid::FREE && next != target) continue;
+
+            int step = dir >= 4 ? g.via_cost
+                     : (pref == 'H' && dir < 2) || (pref == 'V' && dir >= 2) ? g.wrong_way_cost : 1;
+            int d = dist[cur] + step;
+            if (d >= dist[next]) continue;
+            if (dist[next] == INT_MAX) touched.push_back(next);
+            dist[next] = d;
+            from[next] = dir;
+            buckets[(d + h(nl, nx, ny)) % B].push_back(next);
+            pending++;
+        }
+    }
+
+    int result = timed_out ? NOT_ATTEMPTED : -1;
+    if (found) {
+        vector<int>& route = g.routes[rid];
+        route.clear();
+        int via_count = 0;
+        for (int cur = target; cur != start; cur -= offset[from[cur]]) {
+            route.push_back(cur);
+            if (from[cur] >= 4) via_count++;
+        }
+        route.push_back(start);
+        reverse(route.begin(), route.end());
+        for (int cell : route) g.owner[cell] = rid;
+        result = route.size();
+        costs[rid] = dist[target];
+        vias[rid] = via_count;
+    }
+
+    for (int cell : touched) dist[cell] = INT_MAX;
+    touched.clear();
+    for (auto& bucket : buckets) bucket.clear();
+    return result;
+}
+
+bool write_layered_results(const string& filename, const LayeredGrid& g, const map<int,int>& id_to_steps, bool binary){
+    TraceSpan span("write_results");
+    ResultWriter writer(filename, binary, g.M, g.N, id_to_steps.size(), g.L);
+    if (!writer.is_open()) {
+        cout << "Cannot write the result file " << filename << "!\n";
+        return false;
+    }
+    const int offset[6] = {-g.N * g.L, g.N * g.L, -g.L, g.L, 1, -1};
+    for (const auto& [id, steps] : id_to_steps) {
+        RoutedNet net;
+        net.net_id = id;
+        net.steps = steps;
+        auto it = g.routes.find(id);
+        if (steps > 0 && it != g.routes.end()) {
+            const vector<int>& route = it->second;
+            net.sl = g.layer(route[0]), net.sx = g.row(route[0]), net.sy = g.col(route[0]);
+            for (size_t i = 1; i < route.size(); ++i) {
+                int dir = find(offset, offset + 6, route[i] - route[i - 1]) - offset;
+                if (!net.runs.empty() && net.runs.back().first == DIRS[dir]) net.runs.back().second++;
+                else net.runs.push_back({DIRS[dir], 1});
+            }
+        }
+        writer.write(net);
+    }
+    return writer.close();
+}
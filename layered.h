@@ -0,0 +1,74 @@
+#ifndef _LAYERED_H
+#define _LAYERED_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class Deadline;
+
+// Multi-layer maze: L stacked M x N layers joined by vias.
+//
+// Input format:
+//   M N L VIA_COST [WRONG_WAY_COST]
+//   then per layer a direction line ('H', 'V' or '*') followed by M rows of N tokens as in the
+//   2D format ('.', '#', S<id>, E<id>). The S and E of a net may sit on different layers.
+//
+// A step in a layer's preferred direction costs 1 ('H': along a row, 'V': along a column, '*':
+// both), a step against it WRONG_WAY_COST (default 2) and a via to the next layer VIA_COST.
+//
+// Cells are stored layer-interleaved, index = (x * N + y) * L + l, so the cells above and
+// below a cell are its direct neighbours in memory.
+struct LayeredGrid {
+    static constexpr int FREE = -1;
+    static constexpr int OBSTACLE = -2;
+
+    int M = 0, N = 0, L = 0;
+    int via_cost = 1, wrong_way_cost = 2;
+    vector<char> preferred;                         // per layer: 'H', 'V' or '*'
+    vector<int> owner;                              // net id, FREE or OBSTACLE per cell
+    map<int, pair<int, int>> net_points;            // net id => (start index, end index)
+    map<int, vector<int>> routes;                   // net id => cell indices from start to end
+
+    int index(int l, int x, int y) const { return (x * N + y) * L + l; }
+    int layer(int i) const { return i % L; }
+    int row(int i) const { return i / L / N; }
+    int col(int i) const { return i / L % N; }
+};
+
+// True if the first line of the file looks like a layered maze header (at least four numbers)
+bool is_layered_maze(const string& filename);
+// Parses a layered maze held in memory; returns false with `error` set
+bool parse_layered_maze(const char* data, size_t size, LayeredGrid& g, string& error);
+// Exits with a message if the file cannot be read or parsed
+LayeredGrid read_layered_maze(const string& filename);
+
+// BFS/A* on a layered maze. Nets are routed one by one in id order, each blocking its cells
+// for the later ones. Both searches return least-cost routes (Dijkstra and A* over a bucket
+// queue, the heuristic being the Manhattan distance plus VIA_COST per layer of difference).
+class LayeredRouter {
+public:
+    const Deadline* deadline = nullptr;  // when set, nets not routed in time are NOT_ATTEMPTED
+
+    // net id => steps (cells on the route), -1 if routing failed; costs[id] gets the route cost
+    map<int,int> route(LayeredGrid& g, bool use_astar);
+    map<int,int> costs;
+    map<int,int> vias;
+
+private:
+    int search(LayeredGrid& g, int rid, bool use_astar);
+
+    vector<int> dist;         // cost from the start, INT_MAX if not reached
+    vector<uint8_t> from;     // direction taken into the cell
+    vector<int> touched;      // cells to reset before the next net
+    vector<vector<int>> buckets;
+    long long expansions = 0;
+};
+
+// Writes the routes in the result format (see result_io.h) with layer information
+bool write_layered_results(const string& filename, const LayeredGrid& g, const map<int,int>& id_to_steps, bool binary);
+
+#endif
@@ -0,0 +1,121 @@
+#include "line_probe.h"
+#include "deadline.h"
+#include <algorithm>
+
+using namespace std;
+
+int LineProbe::search(const Grid& g, int rid, int start, int end, const Deadline* deadline, vector<int>& route){
+    this->g = &g;
+    this->rid = rid;
+    from = start, to = end;
+    lines.clear();
+    for (int s = 0; s < 2; ++s) rows[s].clear(), cols[s].clear();
+    meet_line[0] = meet_line[1] = meet_cell = -1;
+    probes = 0;
+
+    const int N = g.N;
+    vector<int> level[2], next;
+    bool met = false;
+    for (int s = 0; s < 2 && !met; ++s) {
+        int c = s == 0 ? start : end;
+        met = !probe(s, c / N, c % N, true, -1, level[s]) || !probe(s, c / N, c % N, false, -1, level[s]);
+    }
+
+    // The sides take turns, one level at a time
+    for (int s = 0; !met && !(level[0].empty() && level[1].empty()); s = 1 - s) {
+        next.clear();
+        for (size_t k = 0; k < level[s].size() && !met; ++k) {
+            if (max_probes && probes >= max_probes) return OVER_LIMIT;
+            if (deadline && (k & 255) == 0 && deadline->expired()) return NOT_ATTEMPTED;
+            Line line = lines[level[s][k]];
+            for (int t = line.lo; t <= line.hi && !met; ++t) {
+                int x = line.horizontal ? line.fixed : t, y = line.horizontal ? t : line.fixed;
+                met = !probe(s, x, y, !line.horizontal, level[s][k], next);
+            }
+        }
+        level[s].swap(next);
+    }
+    if (!met) return 0;
+
+    // start .. meeting cell .. end, without the loops lines crossing each other may leave
+    vector<int> cells, back;
+    trace(meet_line[0], meet_cell, cells);
+    reverse(cells.begin(), cells.end());
+    trace(meet_line[1], meet_cell, back);
+    cells.insert(cells.end(), back.begin() + 1, back.end());
+    unordered_map<int, size_t> at;
+    for (int c : cells) {
+        auto it = at.find(c);
+        if (it != at.end()) {
+            for (size_t k = it->second + 1; k < route.size(); ++k) at.erase(route[k]);
+            route.resize(it->second + 1);
+            continue;
+        }
+        at[c] = route.size();
+        route.push_back(c);
+    }
+    return 1;
+}
+
+// Free cells, the net's own end point and the two end points of the search
+bool LineProbe::open(int c) const {
+    if (c == from || c == to) return true;
+    const Cell& cell = g->grid[c / g->N][c % g->N];
+    return (cell.is_end && cell.path_id == rid) || (cell.is_space && cell.path_id == -1);
+}
+
+int LineProbe::covering(int side, int x, int y, bool horizontal) const {
+    const auto& index = horizontal ? rows[side] : cols[side];
+    auto it = index.find(horizontal ? x : y);
+    if (it == index.end()) return -1;
+    int t = horizontal ? y : x;
+    for (int id : it->second)
+        if (lines[id].lo <= t && t <= lines[id].hi) return id;
+    return -1;
+}
+
+bool LineProbe::probe(int side, int x, int y, bool horizontal, int parent, vector<int>& level){
+    if (covering(side, x, y, horizontal) != -1) return true;
+    const int N = g->N;
+    Line line{horizontal, horizontal ? x : y, horizontal ? y : x, horizontal ? y : x, parent, x * N + y};
+    int limit = horizontal ? g->N : g->M;
+    auto cell = [&](int t) { return horizontal ? x * N + t : t * N + y; };
+    while (line.lo > 0 && open(cell(line.lo - 1))) line.lo--;
+    while (line.hi + 1 < limit && open(cell(line.hi + 1))) line.hi++;
+
+    int id = lines.size();
+    lines.push_back(line);
+    (horizontal ? rows[side] : cols[side])[line.fixed].push_back(id);
+    level.push_back(id);
+    probes++;
+
+    // Meets the other side where one of its lines covers a cell of this one
+    for (int t = line.lo; t <= line.hi; ++t) {
+        int cx = horizontal ? x : t, cy = horizontal ? t : y;
+        int other = covering(1 - side, cx, cy, true);
+        if (other == -1) other = covering(1 - side, cx, cy, false);
+        if (other != -1) {
+            meet_line[side] = id, meet_line[1 - side] = other;
+            meet_cell = cx * N + cy;
+            return false;
+        }
+    }
+    return true;
+}
+
+void LineProbe::trace(int id, int cell, vector<int>& cells) const {
+    const int N = g->N;
+    cells.push_back(cell);
+    while (id != -1) {
+        const Line& line = lines[id];
+        // straight along the line to where it was grown from
+        int x = cell / N, y = cell % N, vx = line.via / N, vy = line.via % N;
+        while (x != vx || y != vy) {
+            if (x != vx) x += x < vx ? 1 : -1;
+            else y += y < vy ? 1 : -1;
+            cells.push_back(x * N + y);
+        }
+        cell = line.via;
+        id = line.parent;
+    }
+}
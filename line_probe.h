@@ -0,0 +1,59 @@
+#ifndef _LINE_PROBE_H
+#define _LINE_PROBE_H
+
+#include <unordered_map>
+#include <vector>
+#include "objects.h"
+
+using namespace std;
+
+class Deadline;
+
+// Line-probe router (Mikami-Tabuchi) for sparse, open mazes.
+//
+// Probes are horizontal and vertical lines grown from both end points until they hit a blocked
+// cell. Level 0 are the two lines through each end point; level i + 1 are the lines crossing a
+// level i line of the same side at any of its cells. A line always covers the whole free run
+// through its cell, so a run is probed at most once per side and the memory grows with the
+// number of probes instead of the grid area. The search stops when a line of one side meets a
+// line of the other; the route bends once per line and is not always the shortest.
+class LineProbe {
+public:
+    static const int OVER_LIMIT = -3;  // search() result when max_probes lines were probed
+
+    // max_probes: lines of both sides before giving up, 0 for no limit
+    explicit LineProbe(long long max_probes) : max_probes(max_probes) {}
+
+    // Route of net `rid` from `start` to `end` (linear cell indices x * N + y), appended to
+    // `route` from start to end. Returns 1 if found, 0 if the probes cover everything
+    // reachable without meeting, NOT_ATTEMPTED if `deadline` expired first and OVER_LIMIT if
+    // max_probes was reached.
+    int search(const Grid& g, int rid, int start, int end, const Deadline* deadline, vector<int>& route);
+
+    long long max_probes;
+    long long probes = 0;   // lines probed by the last search
+
+private:
+    struct Line {
+        bool horizontal;
+        int fixed, lo, hi;  // row (horizontal) or column, and the run along it
+        int parent;         // line it was grown from, -1 for level 0
+        int via;            // cell shared with the parent, or the end point for level 0
+    };
+
+    bool open(int c) const;
+    // Line of `side` covering cell (x, y) in that direction, or -1
+    int covering(int side, int x, int y, bool horizontal) const;
+    // Probes the run through (x, y) unless `side` has it; returns false once the sides meet
+    bool probe(int side, int x, int y, bool horizontal, int parent, vector<int>& level);
+    // Cells from `cell` on line `id` back to the end point of its side
+    void trace(int id, int cell, vector<int>& cells) const;
+
+    const Grid* g = nullptr;
+    int rid = -1, from = -1, to = -1;
+    vector<Line> lines;
+    unordered_map<int, vector<int>> rows[2], cols[2];       // per side: lines by row / column
+    int meet_line[2] = {-1, -1}, meet_cell = -1;
+};
+
+#endif
@@ -1,29 +1,110 @@
-#include <SFML/Graphics.hpp>
 #include <iostream>
 #include <map>
+#include <thread>
+#include <chrono>
 #include "objects.h"
+#include "snapshot.h"
+#include "result_io.h"
+#include "deadline.h"
+#include "cache.h"
+#include "server.h"
+#include "landmarks.h"
+#include "layered.h"
 #include "utils.h"
-#include "draw.h"
+#include "trace.h"
+#include "regions.h"
+#include "portfolio.h"
+#ifdef WITH_GUI
+#include "gui.h"
+#endif
+#ifdef WITH_GUROBI
+#include "ilp_solver.h"
+#endif
 
 using namespace std;
 
-// Declare the global variable
-extern map<int, int> id_to_steps;
+// With --regions and --astar, smaller net groups are routed with BFS: A* only makes up for
+// its priority queue on larger areas
+const long long ASTAR_REGION_CELLS = 4096;
 
 void InputFormatError(){
     cout << "Input format error!\n";
     cout << "Correct format:\n";
-    cout << "./main INPUT_MAZE.txt [--print] [--no-gui] [--astar] [--ilp] [--max-iter N] [--time-limit T] [--threads N]\n";
+    cout << "./main INPUT_MAZE.txt [--print] [--no-gui] [--astar] [--hadlock] [--line-probe] [--alt K] [--ilp] [--max-iter N] [--time-limit T] [--threads N] [--local-solver] [--portfolio] [--portfolio-gap G] [--max-cut K] [--edits FILE] [--out FILE] [--out-bin FILE] [--deadline SECONDS] [--cache-dir DIR] [--cache-size MB] [--search-threads N] [--parallel-bfs CELLS] [--regions] [--frontier-cap MB] [--try-orders K] [--window MARGIN] [--view RESULT] [--trace FILE]\n";
+    cout << "       ./main --serve SOCKET|- [--workers N]\n";
+    cout << "  INPUT_MAZE.txt  : A 2D maze, or a multi-layer maze (header \"M N L VIA_COST [WRONG_WAY_COST]\", see layered.h)\n";
+    cout << "  --hadlock       : Hadlock's minimum detour search instead of BFS (shortest routes, usually fewer cells searched)\n";
+    cout << "  --line-probe    : Mikami-Tabuchi line probes for open mazes (few bends, not always the shortest; BFS for the nets they miss)\n";
+    cout << "  --alt K         : A* with K landmark lower bounds precomputed for the maze (implies --astar)\n";
     cout << "  --max-iter N    : Maximum iterations for ILP solver (default: 1)\n";
     cout << "  --time-limit T  : Time limit in seconds for ILP solver (default: 30)\n";
-    cout << "  --threads N     : Number of threads for ILP solver (default: 1)\n";
+    cout << "  --threads N     : Number of conflict components solved in parallel, threads left over go to the Gurobi models (default: 1)\n";
+    cout << "  --local-solver  : Solve ILP conflict components with the built-in branch and bound instead of Gurobi\n";
+    cout << "  --portfolio     : Race the ILP (or local) solver against heuristics on every conflict component, stopping at a proven optimum\n";
+    cout << "  --portfolio-gap G : With --portfolio, also stop once the best is within the fraction G of the proven bound (default: 0)\n";
+    cout << "  --max-cut K     : Vertex cuts of up to K cells found before the ILP solve become extra constraints (default: 3, 0: off)\n";
+    cout << "  --edits FILE    : Apply the maze edits in FILE after routing, re-routing incrementally\n";
+    cout << "  --out FILE      : Write every routed path (start + run-length-encoded moves) as text\n";
+    cout << "  --out-bin FILE  : Same as --out in the compact binary format\n";
+    cout << "  --deadline S    : Wall-clock budget for the whole run; unfinished nets are reported as not attempted\n";
+    cout << "  --cache-dir DIR : Reuse routing results cached in DIR for the same maze and options\n";
+    cout << "  --cache-size MB : Size cap of the cache directory, least recently used entries go first (default: 256)\n";
+    cout << "  --search-threads N : Threads of a single BFS on large grids and of the ILP candidate searches (default: one per core)\n";
+    cout << "  --parallel-bfs CELLS : Grid size from which BFS searches run on the search threads (default: 1048576)\n";
+    cout << "  --regions       : Route the groups of nets in areas separated by obstacle walls in parallel on the search threads\n";
+    cout << "  --frontier-cap MB : BFS/A* keeping only the search frontiers, at most MB megabytes of them per net (the grid is not bounded)\n";
+    cout << "  --try-orders K  : Route K net orders (the file's first, then random ones) from a checkpoint and keep the best\n";
+    cout << "  --window MARGIN : BFS/A* first search within the end points' bounding box plus MARGIN cells, growing it as needed\n";
+    cout << "  --view RESULT   : Show a result saved with --out/--out-bin for this maze, without routing\n";
+    cout << "  --trace FILE    : Write a timeline of the run's phases as Chrome trace events (chrome://tracing, Perfetto)\n";
+    cout << "  --serve SOCKET  : Run as a routing daemon on a Unix socket (\"-\": stdin/stdout), see server.h\n";
+    cout << "  --workers N     : Requests routed in parallel by the daemon (default: one per core)\n";
     exit(1);
 }
 
+void printRoutingResults(const map<int,int>& id_to_steps){
+    cout << "\nRouting results:" << endl;
+
+    for (const auto& [id, steps] : id_to_steps) {
+        if (steps == -1)
+            cout << "Routing failed for net_id " << id << endl;
+        else if (steps == NOT_ATTEMPTED)
+            cout << "Routing not attempted for net_id " << id << " (deadline)" << endl;
+        else
+            cout << "route id: " << id << " => steps: " << steps << endl;
+    }
+    cout << endl;
+
+    // cout << "Printing routed maze:" << endl;
+    // g.print(1);
+}
+
+void saveTrace(const string& trace_file, bool enable_print){
+    if (trace_file.empty()) return;
+    if (!write_trace(trace_file))
+        cout << "Cannot write the trace file " << trace_file << "!\n";
+    else if (enable_print)
+        cout << "Trace written to " << trace_file << endl;
+}
+
 int main(int argc, char** argv) {
+#ifdef WITH_GUROBI
+    set_default_component_solver([]() { return unique_ptr<ComponentSolver>(new ILPSolver()); });
+#endif
+
+    // Daemon mode; stdout may be the response stream, so nothing is printed before this
+    if (argc >= 3 && string(argv[1]) == "--serve") {
+        int workers = thread::hardware_concurrency();
+        if (argc == 5 && string(argv[3]) == "--workers")
+            workers = stoi(argv[4]);
+        else if (argc != 3)
+            InputFormatError();
+        return serve(argv[2], workers);
+    }
+
     cout << "Starting program..." << endl;
     
-    if (argc < 2 || argc > 9) {
+    if (argc < 2) {
         InputFormatError();
     }
 
@@ -32,10 +113,30 @@ int main(int argc, char** argv) {
     bool enable_print = false;
     bool enable_gui = true;
     bool use_astar = false;
+    bool use_hadlock = false;
+    bool use_line_probe = false;
+    int landmark_count = 0;
     bool use_ilp = false;
     int max_iteration = 1;
     double time_limit = 30.0;
     int thread_count = 1;
+    bool use_local_solver = false;
+    bool use_portfolio = false;
+    double portfolio_gap = 0;
+    int max_cut = 3;
+    string edit_file;
+    string out_file, out_bin_file;
+    double deadline_seconds = -1;
+    string cache_dir;
+    double cache_size_mb = 256;
+    int search_threads = max(1u, thread::hardware_concurrency());
+    long long parallel_bfs_cells = 1 << 20;
+    string trace_file;
+    bool use_regions = false;
+    double frontier_cap_mb = 0;
+    int try_orders = 1;
+    int window_margin = -1;
+    string view_file;
 
     cout << "Parsing command line arguments..." << endl;
     for (int i = 2; i < argc; ++i) {
@@ -51,9 +152,33 @@ int main(int argc, char** argv) {
         } 
         else if (arg == "--astar") {
             use_astar = true;
+            use_hadlock = false;
+            use_line_probe = false;
             if(enable_print)
                 cout << "A* algorithm enabled" << endl;
         }
+        else if (arg == "--alt" && i + 1 < argc) {
+            use_astar = true;
+            use_hadlock = false;
+            use_line_probe = false;
+            landmark_count = stoi(argv[++i]);
+            if(enable_print)
+                cout << "A* with " << landmark_count << " landmarks enabled" << endl;
+        }
+        else if (arg == "--hadlock") {
+            use_hadlock = true;
+            use_astar = false;
+            use_line_probe = false;
+            if(enable_print)
+                cout << "Hadlock's algorithm enabled" << endl;
+        }
+        else if (arg == "--line-probe") {
+            use_line_probe = true;
+            use_astar = false;
+            use_hadlock = false;
+            if(enable_print)
+                cout << "Line-probe routing enabled" << endl;
+        }
         else if (arg == "--ilp") {
             use_ilp = true;
             if(enable_print)
@@ -74,126 +199,379 @@ int main(int argc, char** argv) {
             if(enable_print)
                 cout << "Thread count set to: " << thread_count << endl;
         }
+        else if (arg == "--local-solver") {
+            use_local_solver = true;
+            if(enable_print)
+                cout << "Local conflict solver enabled" << endl;
+        }
+        else if (arg == "--portfolio") {
+            use_portfolio = true;
+            if(enable_print)
+                cout << "Solver portfolio enabled" << endl;
+        }
+        else if (arg == "--portfolio-gap" && i + 1 < argc) {
+            use_portfolio = true;
+            portfolio_gap = stod(argv[++i]);
+        }
+        else if (arg == "--max-cut" && i + 1 < argc) {
+            max_cut = stoi(argv[++i]);
+        }
+        else if (arg == "--edits" && i + 1 < argc) {
+            edit_file = argv[++i];
+            if(enable_print)
+                cout << "Edit list: " << edit_file << endl;
+        }
+        else if (arg == "--out" && i + 1 < argc) {
+            out_file = argv[++i];
+        }
+        else if (arg == "--out-bin" && i + 1 < argc) {
+            out_bin_file = argv[++i];
+        }
+        else if (arg == "--cache-dir" && i + 1 < argc) {
+            cache_dir = argv[++i];
+        }
+        else if (arg == "--cache-size" && i + 1 < argc) {
+            cache_size_mb = stod(argv[++i]);
+        }
+        else if (arg == "--search-threads" && i + 1 < argc) {
+            search_threads = stoi(argv[++i]);
+        }
+        else if (arg == "--parallel-bfs" && i + 1 < argc) {
+            parallel_bfs_cells = stoll(argv[++i]);
+        }
+        else if (arg == "--regions") {
+            use_regions = true;
+        }
+        else if (arg == "--frontier-cap" && i + 1 < argc) {
+            frontier_cap_mb = stod(argv[++i]);
+        }
+        else if (arg == "--try-orders" && i + 1 < argc) {
+            try_orders = stoi(argv[++i]);
+        }
+        else if (arg == "--view" && i + 1 < argc) {
+            view_file = argv[++i];
+        }
+        else if (arg == "--window" && i + 1 < argc) {
+            window_margin = stoi(argv[++i]);
+        }
+        else if (arg == "--trace" && i + 1 < argc) {
+            trace_file = argv[++i];
+            start_trace();
+        }
+        else if (arg == "--deadline" && i + 1 < argc) {
+            deadline_seconds = stod(argv[++i]);
+            if(enable_print)
+                cout << "Deadline set to: " << deadline_seconds << " seconds" << endl;
+        }
         else {
             cout << "Unknown argument: " << arg << endl;
             InputFormatError();
         }
     }
 
+    // The budget covers parsing, routing, edits and output. Routing stops a little early
+    // (5%, at most one second) so the best result so far can still be written out.
+    Deadline deadline = deadline_seconds >= 0 ? Deadline(deadline_seconds) : Deadline();
+    Deadline routing_deadline = deadline.reserve(min(1.0, deadline_seconds * 0.05));
+
+#ifndef WITH_GUROBI
+    if (use_ilp && !use_local_solver) {
+        if(enable_print)
+            cout << "Built without Gurobi, using the local conflict solver" << endl;
+        use_local_solver = true;
+    }
+#endif
+
+    // Multi-layer mazes are routed without a window by LayeredRouter
+    if (is_layered_maze(input_file)) {
+        if (use_ilp || !edit_file.empty() || !cache_dir.empty() || landmark_count > 0 || !view_file.empty()) {
+            cout << "--ilp, --alt, --edits, --cache-dir and --view are not supported on layered mazes" << endl;
+            exit(1);
+        }
+        if(enable_print)
+            cout << "Reading layered maze from file: " << input_file << endl;
+        LayeredGrid lg = read_layered_maze(input_file);
+        if(enable_print)
+            cout << lg.L << " layers of " << lg.M << " x " << lg.N << ", via cost " << lg.via_cost
+                 << ", wrong-way cost " << lg.wrong_way_cost << endl;
+
+        LayeredRouter lr;
+        if (deadline.is_limited())
+            lr.deadline = &routing_deadline;
+        auto t0 = chrono::steady_clock::now();
+        map<int,int> result = lr.route(lg, use_astar);
+        if(enable_print)
+            cout << "Routed " << result.size() << " nets with " << (use_astar ? "A*" : "BFS") << " in "
+                 << chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count() << " ms" << endl;
+
+        if (!out_file.empty() && write_layered_results(out_file, lg, result, false) && enable_print)
+            cout << "Routed paths written to " << out_file << endl;
+        if (!out_bin_file.empty() && write_layered_results(out_bin_file, lg, result, true) && enable_print)
+            cout << "Routed paths written to " << out_bin_file << endl;
+
+        if(enable_print) {
+            cout << "\nRouting results:" << endl;
+            for (const auto& [id, steps] : result) {
+                if (steps == -1)
+                    cout << "Routing failed for net_id " << id << endl;
+                else if (steps == NOT_ATTEMPTED)
+                    cout << "Routing not attempted for net_id " << id << " (deadline)" << endl;
+                else
+                    cout << "route id: " << id << " => steps: " << steps << " (vias: " << lr.vias[id]
+                         << ", cost: " << lr.costs[id] << ")" << endl;
+            }
+            cout << endl;
+        }
+        saveTrace(trace_file, enable_print);
+        if(enable_print)
+            cout << "Program finished successfully." << endl;
+        cout.flush();
+        exit(0);  // leave the freeing of the layers to the OS
+    }
+
     // Reading maze
     if(enable_print)
         cout << "Reading maze from file: " << input_file << endl;
     Grid g = read_maze(argv[1]);
+
+    // A saved result is shown as it is, without a Router
+    if (!view_file.empty()) {
+        RoutedResult saved;
+        map<int,int> result;
+        if (!map_results(view_file, saved)) {
+            cout << "Cannot read the result file " << view_file << endl;
+            exit(1);
+        }
+        if (!apply_results(saved, g, result)) {
+            cout << view_file << " is not a result of " << input_file << endl;
+            exit(1);
+        }
+        if(enable_print)
+            printRoutingResults(result);
+#ifdef WITH_GUI
+        if (enable_gui)
+            return viewGui(g, result, enable_print);
+#else
+        if (enable_gui)
+            cout << "Built without the GUI, nothing to show" << endl;
+#endif
+        return 0;
+    }
     // if (enable_print) {
     //     cout << "Printing original maze:" << endl;
     //     g.print(0);
     // }
 
-    Router r;
+    vector<Edit> edits;
+    if (!edit_file.empty())
+        edits = read_edits(edit_file);
 
-    if(enable_print)
-        cout << "Starting routing..." << endl;
+    SearchMode search_mode = use_hadlock ? SEARCH_HADLOCK : use_astar ? SEARCH_ASTAR : use_line_probe ? SEARCH_LINEPROBE : SEARCH_BFS;
 
-    // Store routing results in the global id_to_steps
-    if (use_ilp) {
-        if(enable_print)
-            cout << "Using ILP algorithm for routing" << endl;
-        id_to_steps = r.route_with_ilp(g, max_iteration, time_limit, thread_count);
-    } 
-    else {
+    // Areas separated by obstacle walls; a single group of nets is routed the usual way
+    RegionMap regions;
+    if (use_regions && (use_ilp || frontier_cap_mb > 0 || try_orders > 1 || window_margin >= 0)) {
+        cout << "--regions is ignored with --ilp, --frontier-cap, --try-orders and --window" << endl;
+        use_regions = false;
+    }
+    if (use_regions) {
+        regions = find_regions(g);
         if(enable_print)
-            cout << "Using " << (use_astar ? "A*" : "BFS") << " algorithm for routing" << endl;
-        id_to_steps = r.route(g, use_astar);
+            cout << regions.regions << " regions, " << regions.groups.size() << " independent groups of nets" << endl;
     }
 
-    if(enable_print){
-
-        cout << "\nRouting results:" << endl;
-
-        for (const auto& [id, steps] : id_to_steps) {
-            if (steps == -1)
-                cout << "Routing failed for net_id " << id << endl;
-            else
-                cout << "route id: " << id << " => steps: " << steps << endl;
+    Router r;
+    LocalSolver local_solver;
+    // --portfolio races the conflict solver against the heuristics
+    unique_ptr<ComponentSolver> exact_solver;
+    ComponentSolver* component_solver = use_local_solver ? &local_solver : nullptr;
+    unique_ptr<PortfolioSolver> portfolio;
+    if (use_ilp && use_portfolio) {
+        if (!component_solver) {
+            exact_solver = default_component_solver();
+            component_solver = exact_solver.get();
         }
-        cout << endl;
-
-        // cout << "Printing routed maze:" << endl;
-        // g.print(1);
+        portfolio.reset(new PortfolioSolver(*component_solver, portfolio_gap));
+        component_solver = portfolio.get();
     }
+    Landmarks landmarks;
+    if (deadline.is_limited())
+        r.deadline = &routing_deadline;
+    r.search_threads = search_threads;
+    r.parallel_bfs_cells = parallel_bfs_cells;
+    r.max_cut = max_cut;
+    if (frontier_cap_mb > 0)
+        r.frontier_cap = (size_t)(frontier_cap_mb * 1024 * 1024);
+    r.window_margin = window_margin;
+    if (enable_print && search_mode == SEARCH_BFS && !use_ilp && regions.groups.size() <= 1 && search_threads > 1 && !r.frontier_cap &&
+        (long long)g.M * g.N >= parallel_bfs_cells)
+        cout << "Parallel BFS on " << search_threads << " threads" << endl;
 
+    ResultCache cache(cache_dir, (uint64_t)(cache_size_mb * 1024 * 1024));
+    // Everything besides the maze that changes the routing result
+    string cache_options = use_ilp ? "ilp max-iter=" + to_string(max_iteration) + " time-limit=" + to_string(time_limit) +
+                                     " max-cut=" + to_string(max_cut) + (use_local_solver ? " local" : " gurobi")
+                                   : use_astar ? "astar alt=" + to_string(landmark_count) + (regions.groups.size() > 1 ? " regions" : "")
+                                               : search_name(search_mode);
+    // Frontier search finds other (equally short) routes and fails nets over the cap
+    if (!use_ilp && r.frontier_cap)
+        cache_options += " frontier-cap=" + to_string(r.frontier_cap);
+    // What the components solved in parallel finish within the time limit depends on the threads
+    if (use_ilp && time_limit > 0)
+        cache_options += " threads=" + to_string(thread_count);
+    // The portfolio may keep another choice of the same size (or a smaller one within the gap)
+    if (portfolio)
+        cache_options += " portfolio=" + to_string(portfolio_gap);
+    if (!use_ilp && try_orders > 1)
+        cache_options += " orders=" + to_string(try_orders);
+    if (!use_ilp && !r.frontier_cap && !use_line_probe && window_margin >= 0)
+        cache_options += " window=" + to_string(window_margin);
 
-    if (enable_gui) {
-        try {
-            if(enable_print)
-                cout << "Initializing GUI..." << endl;
-            // Building SFML window
-            // -> user's screen size
-            sf::VideoMode desktop = sf::VideoMode::getDesktopMode();
-            int screenW = desktop.width;
-            int screenH = desktop.height;
-            // -> control windows size
-            int cellSize = max(min((screenW * 2/3) / g.N, (screenH * 2/3) / g.M), 4);
-            int windowWidth = g.N * cellSize;
-            int windowHeight = g.M * cellSize;
-            int buttonPanelHeight = 100;
-            float PanelHeightRate = (float) buttonPanelHeight / (float) (buttonPanelHeight + windowHeight);
-            
-            if(enable_print)
-                cout << "Creating window with size: " << windowWidth << "x" << (windowHeight + buttonPanelHeight) << endl;
-            
-            sf::RenderWindow window(sf::VideoMode(windowWidth, windowHeight + buttonPanelHeight), "Maze Routing");
-            if (!window.isOpen()) {
-                cout << "Failed to create window!" << endl;
-                return 1;
-            }
+    auto run_routing = [&]() {
+        if(enable_print)
+            cout << "Starting routing..." << endl;
+
+        map<int,int> result;
+        string cache_key;
+        bool cache_hit = false;
+        if (!cache_dir.empty()) {
+            cache_key = cache.key(g, cache_options);
+            cache_hit = cache.load(cache_key, g, result);
+            if(enable_print)
+                cout << "Result cache " << (cache_hit ? "hit" : "miss") << " (" << cache_key << ")" << endl;
+            if (cache_hit && r.snapshot)
+                r.snapshot->init(g);
+        }
 
-            // Update window title with routing progress
-            int total_routes = g.net_points.size();
-            int completed_routes = 0;
-            for (const auto& [id, steps] : id_to_steps) {
-                if (steps != -1) completed_routes++;
+        if (cache_hit) {
+            if(enable_print)
+                cout << "Loaded " << result.size() << " nets from the cache" << endl;
+        }
+        else if (use_ilp) {
+            if(enable_print)
+                cout << "Using ILP algorithm for routing" << endl;
+            result = r.route_with_ilp(g, max_iteration, time_limit, thread_count, component_solver);
+            if(enable_print)
+                cout << "ILP candidates: " << r.ilp_stats.paths << ", conflict-free: " << r.ilp_stats.conflict_free
+                     << ", conflict components: " << r.ilp_stats.components << " (largest " << r.ilp_stats.largest
+                     << "), solve time: " << r.ilp_stats.solve_seconds << " s" << endl;
+            if(enable_print && max_cut > 0)
+                cout << "Vertex cuts: " << r.ilp_stats.cuts << ", cut constraints: " << r.ilp_stats.cut_constraints
+                     << ", components proved optimal by the cuts: " << r.ilp_stats.proved_by_cuts
+                     << ", analysis time: " << r.ilp_stats.cut_seconds << " s" << endl;
+            if(enable_print && portfolio)
+                cout << "Portfolio: " << portfolio->stats.raced << " components raced, best found by greedy "
+                     << portfolio->stats.won[SharedIncumbent::GREEDY] << " / local search "
+                     << portfolio->stats.won[SharedIncumbent::LOCAL_SEARCH] << " / " << (use_local_solver ? "branch and bound " : "ILP ")
+                     << portfolio->stats.won[SharedIncumbent::EXACT] << ", proven optimal " << portfolio->stats.proven
+                     << ", within the gap " << portfolio->stats.within_gap << endl;
+        } 
+        else {
+            if(enable_print)
+                cout << "Using " << (use_astar ? "A*" : use_hadlock ? "Hadlock's" : use_line_probe ? "line-probe" : "BFS") << " algorithm for routing" << endl;
+            if (use_astar && landmark_count > 0) {
+                auto t0 = chrono::steady_clock::now();
+                landmarks.build(g, landmark_count, thread::hardware_concurrency());
+                r.landmarks = &landmarks;
+                if(enable_print)
+                    cout << landmarks.size() << " landmarks computed in "
+                         << chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count() << " ms" << endl;
             }
-            window.setTitle("Maze Routing - " + std::to_string(completed_routes) + "/" + std::to_string(total_routes) + " routes found!");
-
-            // Initialize SFML Window
-            window.clear();
-            renderMaze(g, window, cellSize);
-            window.display();
-           
-            if(enable_print)
-                cout << "Window created successfully. Starting main loop..." << endl;
-            
-            // Main Loop        
-            while (window.isOpen()) {
-                sf::Event event;
-                while (window.pollEvent(event)) {
-                    if (event.type == sf::Event::Closed)
-                        window.close();
-                    else if (event.type == sf::Event::MouseButtonPressed) {
-                        if (event.mouseButton.button == sf::Mouse::Left) {
-                            // Convert mouse position to world coordinates
-                            sf::Vector2f worldPos = window.mapPixelToCoords(
-                                sf::Vector2i(event.mouseButton.x, event.mouseButton.y)
-                            );
-                            // Handle button clicks
-                            handleButtonClick(worldPos, window, PanelHeightRate);
-                        }
-                    }          
-                }
-
-                window.clear();
-                renderMaze(g, window, cellSize);
-                window.display();
+            if (regions.groups.size() > 1) {
+                auto choose = [&](const NetGroup& group) {
+                    return use_astar && group.cells < ASTAR_REGION_CELLS ? SEARCH_BFS : search_mode;
+                };
+                auto t0 = chrono::steady_clock::now();
+                result = r.route_regions(g, regions, search_threads, choose);
+                if(enable_print)
+                    cout << "Routed " << regions.groups.size() << " groups on " << min<size_t>(search_threads, regions.groups.size())
+                         << " threads in " << chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count()
+                         << " ms" << endl;
             }
-        } 
-        catch (const std::exception& e) {
-            cout << "Error creating window: " << e.what() << endl;
-            return 1;
+            else if (try_orders > 1) {
+                auto t0 = chrono::steady_clock::now();
+                result = r.try_orders(g, try_orders, search_mode);
+                if(enable_print)
+                    cout << "Tried " << try_orders << " net orders in "
+                         << chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count() << " ms" << endl;
+            }
+            else
+                result = r.route(g, search_mode);
+            if(enable_print && window_margin >= 0 && !r.frontier_cap && !use_line_probe)
+                cout << "Window search (margin " << window_margin << "): " << r.expanded_cells << " cells expanded, "
+                     << r.window_retries << " retries with a larger window, " << r.window_fallbacks
+                     << " nets searched on the whole grid" << endl;
+            if(enable_print && use_line_probe && !r.frontier_cap)
+                cout << "Line probes: " << r.probes << " lines, " << r.probe_fallbacks << " nets routed with BFS instead" << endl;
+            if(enable_print && r.frontier_cap)
+                cout << "Frontier search: peak " << r.frontier_peak / 1048576.0 << " MB of " << frontier_cap_mb
+                     << " MB cap, " << r.over_cap << " nets over the cap" << endl;
         }
-    }
 
+        // Results cut short by the deadline are not worth keeping
+        if (!cache_dir.empty() && !cache_hit) {
+            bool complete = true;
+            for (const auto& [id, steps] : result)
+                if (steps == NOT_ATTEMPTED) complete = false;
+            if (complete && r.snapshot && r.snapshot->cancelled()) complete = false;
+            if (complete)
+                cache.store(cache_key, g, result);
+        }
+
+        // Scripted edits are re-routed incrementally on top of the first result
+        for (size_t k = 0; k < edits.size(); ++k) {
+            auto t0 = chrono::steady_clock::now();
+            bool ok = r.apply_edit(g, edits[k], result, search_mode);
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+            if(enable_print)
+                cout << "Edit " << k + 1 << (ok ? " applied" : " rejected") << " in " << ms << " ms" << endl;
+        }
+
+        // Edits made later in the GUI are not bound by the run's budget
+        r.deadline = nullptr;
+        if (enable_print && deadline.is_limited()) {
+            int skipped = 0;
+            for (const auto& [id, steps] : result)
+                if (steps == NOT_ATTEMPTED) skipped++;
+            if (skipped)
+                cout << "Deadline reached: " << skipped << " of " << result.size() << " nets not attempted" << endl;
+        }
+
+        if (!out_file.empty() && write_results(out_file, g, result, false) && enable_print)
+            cout << "Routed paths written to " << out_file << endl;
+        if (!out_bin_file.empty() && write_results(out_bin_file, g, result, true) && enable_print)
+            cout << "Routed paths written to " << out_bin_file << endl;
+
+        if(enable_print)
+            printRoutingResults(result);
+        return result;
+    };
+
+#ifndef WITH_GUI
+    if (enable_gui) {
+        cout << "Built without the GUI, routing without a window" << endl;
+        enable_gui = false;
+    }
+#endif
+    if (!enable_gui) {
+        run_routing();
+    }
+#ifdef WITH_GUI
+    else {
+        int status = runGui(g, r, run_routing, search_mode, enable_print);
+        saveTrace(trace_file, enable_print);
+        if (status != 0) return status;
+    }
+#endif
+    if (!enable_gui)
+        saveTrace(trace_file, enable_print);
     if(enable_print)
         cout << "Program finished successfully." << endl;
+    // Freeing a large grid cell by cell can take a sizeable part of a short budget; exit()
+    // leaves it to the OS
+    if (deadline.is_limited()) {
+        cout.flush();
+        exit(0);
+    }
     return 0;
 }
@@ -8,6 +8,7 @@
 #include <ctime>
 #include <cstdlib>
 #include <sstream>
+#include <algorithm>
 
 using namespace std;
 
@@ -60,9 +61,205 @@ bool bfs_path(Cell start, Cell end, const vector<vector<string>>& maze, vector<C
     return false;
 }
 
+// Planted-solution instances
+//
+// `planted` cell-disjoint paths are carved first, so routing all of them at once is possible.
+// Every decoy net starts next to the start of a planted net, both walled in a pocket whose only
+// exit is the planted path's second cell: at most one of the two can be routed. The best
+// routed count is therefore exactly `planted`, which is written to a sidecar .opt file.
+struct Planted {
+    int M, N;
+    vector<vector<int>> owner;      // planted path index, -1 free
+    vector<vector<bool>> wall;      // pocket walls and obstacles
+    vector<vector<string>> maze;
+};
+
+static int dx4[] = {-1, 1, 0, 0};
+static int dy4[] = {0, 0, -1, 1};
+
+static bool inside(const Planted& p, int x, int y) {
+    return x >= 0 && x < p.M && y >= 0 && y < p.N;
+}
+
+// Random walk with a preference for going straight; keeps one free cell between paths and
+// never touches itself, so the planted route is the only way along the path
+static bool plant_path(Planted& p, int id, int min_len, int max_len, vector<Cell>& path) {
+    path.clear();
+    int x = rand() % p.M, y = rand() % p.N;
+    auto ok = [&](int cx, int cy, int px, int py) {
+        if (!inside(p, cx, cy) || p.owner[cx][cy] != -1) return false;
+        for (int d = 0; d < 4; ++d) {
+            int nx = cx + dx4[d], ny = cy + dy4[d];
+            if (!inside(p, nx, ny) || (nx == px && ny == py)) continue;
+            if (p.owner[nx][ny] != -1) return false;  // another path, or an earlier cell of this one
+        }
+        return true;
+    };
+    if (!ok(x, y, -1, -1)) return false;
+
+    int len = min_len + rand() % (max_len - min_len + 1);
+    int dir = rand() % 4;
+    p.owner[x][y] = id;
+    path.push_back(Cell(x, y));
+    while ((int)path.size() < len) {
+        int order[4] = {dir, rand() % 4, rand() % 4, rand() % 4};
+        if (rand() % 4 == 0) swap(order[0], order[1]);
+        bool moved = false;
+        for (int k = 0; k < 4 && !moved; ++k) {
+            int nx = x + dx4[order[k]], ny = y + dy4[order[k]];
+            if (!ok(nx, ny, x, y)) continue;
+            dir = order[k];
+            x = nx, y = ny;
+            p.owner[x][y] = id;
+            path.push_back(Cell(x, y));
+            moved = true;
+        }
+        if (!moved) break;
+    }
+    if ((int)path.size() >= min_len) return true;
+    for (auto& c : path) p.owner[c.x][c.y] = -1;
+    return false;
+}
+
+// Obstacle-only reachability
+static bool reachable(const Planted& p, Cell from, Cell to) {
+    vector<vector<bool>> seen(p.M, vector<bool>(p.N, false));
+    vector<Cell> queue = {from};
+    seen[from.x][from.y] = true;
+    for (size_t head = 0; head < queue.size(); ++head) {
+        Cell c = queue[head];
+        if (c == to) return true;
+        for (int d = 0; d < 4; ++d) {
+            int nx = c.x + dx4[d], ny = c.y + dy4[d];
+            if (!inside(p, nx, ny) || seen[nx][ny] || p.wall[nx][ny]) continue;
+            seen[nx][ny] = true;
+            queue.push_back(Cell(nx, ny));
+        }
+    }
+    return false;
+}
+
+static int generate_planted(int M, int N, int planted, int decoys, double density, unsigned seed) {
+    srand(seed);
+    Planted p{M, N, vector<vector<int>>(M, vector<int>(N, -1)), vector<vector<bool>>(M, vector<bool>(N, false)),
+              vector<vector<string>>(M, vector<string>(N, "."))};
+
+    int min_len = max(4, (M + N) / 8), max_len = max(min_len, (M + N) / 2);
+    vector<vector<Cell>> paths;
+    for (int tries = 0; (int)paths.size() < planted && tries < planted * 200; ++tries) {
+        vector<Cell> path;
+        if (plant_path(p, paths.size(), min_len, max_len, path)) paths.push_back(path);
+    }
+
+    // Pockets: decoy start d next to the planted path's second cell, walled in with the start
+    vector<pair<Cell, int>> decoy_starts;   // (cell, planted path it competes with)
+    vector<bool> pocketed(paths.size(), false);
+    for (int tries = 0; (int)decoy_starts.size() < decoys && tries < decoys * 50 && !paths.empty(); ++tries) {
+        int k = rand() % paths.size();
+        if (pocketed[k]) continue;
+        Cell s = paths[k][0], door = paths[k][1];
+        int d = rand() % 4;
+        Cell c(door.x + dx4[d], door.y + dy4[d]);
+        if (!inside(p, c.x, c.y) || p.owner[c.x][c.y] != -1 || p.wall[c.x][c.y]) continue;
+        vector<Cell> walls;
+        bool ok = true;
+        for (Cell in : {s, c}) {
+            for (int e = 0; e < 4 && ok; ++e) {
+                Cell w(in.x + dx4[e], in.y + dy4[e]);
+                if (!inside(p, w.x, w.y) || w == door || w == s || w == c) continue;
+                if (p.owner[w.x][w.y] != -1) ok = false;
+                for (auto& [other, _] : decoy_starts)
+                    if (w == other) ok = false;
+                walls.push_back(w);
+            }
+        }
+        if (!ok) continue;
+        for (Cell w : walls) p.wall[w.x][w.y] = true;
+        pocketed[k] = true;
+        decoy_starts.push_back({c, k});
+    }
+
+    // Obstacles everywhere else
+    for (int i = 0; i < M; ++i)
+        for (int j = 0; j < N; ++j) {
+            bool pocket = false;
+            for (auto& [c, _] : decoy_starts)
+                if (c.x == i && c.y == j) pocket = true;
+            if (p.owner[i][j] == -1 && !pocket && (double)rand() / RAND_MAX < density)
+                p.wall[i][j] = true;
+        }
+
+    // Decoy ends: far away, reachable through the door
+    vector<pair<Cell, Cell>> nets;
+    vector<bool> is_planted;
+    for (auto& path : paths) {
+        nets.push_back({path.front(), path.back()});
+        is_planted.push_back(true);
+    }
+    for (auto& [c, k] : decoy_starts) {
+        for (int tries = 0; tries < 200; ++tries) {
+            Cell e(rand() % M, rand() % N);
+            if (p.wall[e.x][e.y] || p.owner[e.x][e.y] != -1 || abs(e.x - c.x) + abs(e.y - c.y) < (M + N) / 4) continue;
+            bool used = false;
+            for (auto& [s2, e2] : nets)
+                if (e == s2 || e == e2) used = true;
+            if (used || !reachable(p, c, e)) continue;
+            nets.push_back({c, e});
+            is_planted.push_back(false);
+            break;
+        }
+    }
+
+    // Shuffled net ids, so decoys and planted nets interleave in routing order
+    vector<int> ids(nets.size());
+    for (size_t i = 0; i < ids.size(); ++i) ids[i] = i + 1;
+    for (size_t i = ids.size(); i > 1; --i) swap(ids[i - 1], ids[rand() % i]);
+
+    for (int i = 0; i < M; ++i)
+        for (int j = 0; j < N; ++j)
+            if (p.wall[i][j]) p.maze[i][j] = "#";
+    for (size_t i = 0; i < nets.size(); ++i) {
+        auto [s, e] = nets[i];
+        p.maze[s.x][s.y] = "S" + to_string(ids[i]);
+        p.maze[e.x][e.y] = "E" + to_string(ids[i]);
+    }
+
+    string base = "maze_" + to_string(M) + "x" + to_string(N) + "_planted";
+    ofstream fout(base + ".txt");
+    fout << M << " " << N << "\n";
+    for (int i = 0; i < M; ++i) {
+        for (int j = 0; j < N; ++j) {
+            fout << " " << p.maze[i][j];
+        }
+        fout << "\n";
+    }
+
+    ofstream opt(base + ".opt");
+    opt << "# best achievable routed net count (planted disjoint paths)\n";
+    opt << "optimum " << paths.size() << "\n";
+    opt << "nets " << nets.size() << "\n";
+    opt << "seed " << seed << "\n";
+    opt << "planted";
+    vector<int> planted_ids;
+    for (size_t i = 0; i < nets.size(); ++i)
+        if (is_planted[i]) planted_ids.push_back(ids[i]);
+    sort(planted_ids.begin(), planted_ids.end());
+    for (int id : planted_ids) opt << " " << id;
+    opt << "\n";
+
+    cout << "Planted " << paths.size() << " paths and " << nets.size() - paths.size() << " decoy nets\n";
+    cout << "Maze generated and saved to: " << base << ".txt (optimum in " << base << ".opt)\n";
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
+    if (argc >= 7 && string(argv[1]) == "--planted") {
+        unsigned seed = argc >= 8 ? stoul(argv[7]) : time(0);
+        return generate_planted(stoi(argv[2]), stoi(argv[3]), stoi(argv[4]), stoi(argv[5]), stod(argv[6]), seed);
+    }
     if (argc != 5) {
         cout << "Usage: ./maze_generator M N net_count obstacle_density\n";
+        cout << "       ./maze_generator --planted M N planted_nets decoy_nets obstacle_density [seed]\n";
         return 1;
     }
 
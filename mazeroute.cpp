@@ -0,0 +1,51 @@
+#include "mazeroute.h"
+
+using namespace std;
+
+map<int,int> MazeRouter::route(Grid& g, const RouteOptions& options){
+    Deadline deadline = options.deadline >= 0 ? Deadline(options.deadline) : Deadline();
+    router.clear();
+    router.deadline = deadline.is_limited() ? &deadline : nullptr;
+    router.search_threads = options.search_threads;
+    router.parallel_bfs_cells = options.parallel_bfs_cells;
+    router.max_cut = options.max_cut;
+    router.frontier_cap = options.frontier_cap;
+    router.window_margin = options.window_margin;
+
+    map<int,int> result;
+    if (options.algorithm == RouteOptions::ILP) {
+        ComponentSolver* solver = &local_solver;
+        if (!options.local_solver) {
+            if (!default_solver) default_solver = default_component_solver();
+            solver = default_solver.get();
+        }
+        if (options.portfolio) {
+            PortfolioSolver portfolio(*solver, options.portfolio_gap);
+            result = router.route_with_ilp(g, options.max_iteration, options.time_limit, options.thread_count, &portfolio);
+        }
+        else
+            result = router.route_with_ilp(g, options.max_iteration, options.time_limit, options.thread_count, solver);
+    }
+    else {
+        bool use_astar = options.algorithm == RouteOptions::ASTAR;
+        SearchMode mode = use_astar ? SEARCH_ASTAR : options.algorithm == RouteOptions::HADLOCK ? SEARCH_HADLOCK
+                        : options.algorithm == RouteOptions::LINEPROBE ? SEARCH_LINEPROBE : SEARCH_BFS;
+        if (use_astar && options.landmarks > 0) {
+            landmarks.build(g, options.landmarks);
+            router.landmarks = &landmarks;
+        }
+        RegionMap regions;
+        if (options.regions && !options.frontier_cap && options.try_orders <= 1 && options.window_margin < 0) regions = find_regions(g);
+        if (regions.groups.size() > 1)
+            result = router.route_regions(g, regions, options.search_threads,
+                                          [mode](const NetGroup&) { return mode; });
+        else if (options.try_orders > 1)
+            result = router.try_orders(g, options.try_orders, mode);
+        else
+            result = router.route(g, mode);
+    }
+
+    router.deadline = nullptr;
+    router.landmarks = nullptr;
+    return result;
+}
@@ -0,0 +1,70 @@
+#ifndef _MAZEROUTE_H
+#define _MAZEROUTE_H
+
+// Public header of libmazeroute, the routing core without SFML or Gurobi:
+//
+//   Grid g;
+//   string error;
+//   ifstream in("maze.txt");
+//   if (parse_maze(in, g, error)) {
+//       MazeRouter router;
+//       RouteOptions options;
+//       options.algorithm = RouteOptions::ASTAR;
+//       map<int,int> steps = router.route(g, options);
+//       write_results("routes.txt", g, steps, false);
+//   }
+
+#include <map>
+#include <memory>
+#include "objects.h"
+#include "utils.h"
+#include "path.h"
+#include "conflict_solver.h"
+#include "result_io.h"
+#include "deadline.h"
+#include "cache.h"
+#include "landmarks.h"
+#include "layered.h"
+#include "regions.h"
+#include "portfolio.h"
+
+using namespace std;
+
+struct RouteOptions {
+    enum Algorithm { BFS, ASTAR, ILP, HADLOCK, LINEPROBE };
+    Algorithm algorithm = BFS;
+    int landmarks = 0;          // A*: landmark lower bounds computed for the maze (see landmarks.h)
+    int max_iteration = 1;      // ILP iterations
+    double time_limit = 30.0;   // ILP time limit per iteration, seconds
+    int thread_count = 1;       // ILP conflict components solved in parallel
+    bool local_solver = false;  // ILP: built-in solver instead of default_component_solver()
+    int max_cut = 3;            // ILP: largest vertex cut of the pre-analysis, 0 for none
+    bool portfolio = false;     // ILP: race the solver against heuristics (see portfolio.h)
+    double portfolio_gap = 0;   // ILP portfolio: stop within this fraction of the proven bound
+    int search_threads = 1;     // BFS: threads per search on grids of at least parallel_bfs_cells cells
+    long long parallel_bfs_cells = 1 << 20;
+    bool regions = false;       // BFS/A*: route the groups of find_regions() on search_threads threads
+    size_t frontier_cap = 0;    // BFS/A*: frontier search under this many bytes of search state
+                                // (see frontier_search.h), 0 for the usual searches
+    int try_orders = 1;         // BFS/A*: net orders tried with Router::try_orders(), best kept
+    int window_margin = -1;     // BFS/A*: bounding-box window search margin (see Router), -1 for none
+    double deadline = -1;       // budget for the whole call in seconds, negative for none
+};
+
+// Routes whole mazes. The Router and the solvers (with their Gurobi environments, if any)
+// are kept between calls, so keep one MazeRouter per thread and reuse it.
+class MazeRouter {
+public:
+    // Routes every net of the unrouted grid `g`; returns net id -> steps
+    // (-1 when no route exists, NOT_ATTEMPTED when the deadline came first)
+    map<int,int> route(Grid& g, const RouteOptions& options);
+
+    Router router;
+
+private:
+    LocalSolver local_solver;
+    unique_ptr<ComponentSolver> default_solver;
+    Landmarks landmarks;
+};
+
+#endif
@@ -3,9 +3,24 @@
 #include <queue>
 #include <map>
 #include <set>
+#include <string>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <climits>
 #include "objects.h"
 #include "path.h"
-#include "ilp_solver.h"
+#include "snapshot.h"
+#include "deadline.h"
+#include "landmarks.h"
+#include "parallel_bfs.h"
+#include "cut_analysis.h"
+#include "regions.h"
+#include "frontier_search.h"
+#include "line_probe.h"
+#include "trace.h"
 
 using namespace std;
 
@@ -33,66 +48,304 @@ vector<Cell*> Grid::get_neighbors(Cell* c){
 };
 
 
+Grid::Grid(const Grid& other){
+    *this = other;
+}
+
+Grid& Grid::operator=(const Grid& other){
+    if (this == &other) return *this;
+    grid = other.grid;
+    M = other.M, N = other.N;
+    auto own = [this](const Cell* c) { return c ? &grid[c->x][c->y] : nullptr; };
+    for (auto& row : grid)
+        for (auto& c : row) c.parent = nullptr;
+    net_points.clear();
+    for (const auto& [id, endpoints] : other.net_points)
+        net_points[id] = {own(endpoints.first), own(endpoints.second)};
+    routes.clear();
+    for (const auto& [id, cells] : other.routes) {
+        vector<Cell*>& route = routes[id];
+        route.reserve(cells.size());
+        for (Cell* c : cells) route.push_back(own(c));
+    }
+    journal.reset();
+    return *this;
+}
+
+// Prints the maze in the input format, with every routed cell labelled by its net id.
+// The whole maze is formatted into one buffer and written at once.
 void Grid::print(int mode = 0) {
+    string out;
     if(mode == 0){
-        cout << "Print the original maze:\n";
+        out += "Print the original maze:\n";
     }
     else if(mode == 1){
-        cout << "Print the solution to the maze routing problem:\n";
+        out += "Print the solution to the maze routing problem:\n";
     }
 
+    size_t width = 1;
+    for (const auto& [id, _] : net_points)
+        width = max(width, to_string(id).size() + 1);
+
+    string token;
+    out.reserve(out.size() + (size_t)M * (N * (width + 1) + 1) + 1);
     for (int i = 0; i < M; ++i) {
         for (int j = 0; j < N; ++j) {
             const Cell& c = grid[i][j];
-            if (c.is_obstacle) cout << '#';
-            else if (c.path_id != -1){
-                cout << c.path_id;
-            }
-            else cout << '.';
+            if (c.is_obstacle) token = "#";
+            else if (c.is_start) token = "S" + to_string(c.path_id);
+            else if (c.is_end) token = "E" + to_string(c.path_id);
+            else if (mode == 1 && c.path_id != -1) token = to_string(c.path_id);
+            else token = ".";
+            if (j) out += ' ';
+            out.append(width - token.size(), ' ');
+            out += token;
         }
-        cout << endl;
+        out += '\n';
     }
-    cout << endl;
+    out += '\n';
+    cout.write(out.data(), out.size());
+    cout.flush();
 }
 
-
 // Maze Routing main algorithm (BFS / Lee's algo)
-map<int,int> Router::route(Grid& g, bool use_astar){
+const char* search_name(SearchMode mode){
+    return mode == SEARCH_ASTAR ? "astar" : mode == SEARCH_HADLOCK ? "hadlock" : mode == SEARCH_LINEPROBE ? "lineprobe" : "bfs";
+}
+
+map<int,int> Router::route(Grid& g, SearchMode mode){
+    vector<int> order;
+    order.reserve(g.net_points.size());
+    for (const auto& [id, _] : g.net_points) order.push_back(id);
+    return route_order(g, order, mode);
+}
+
+map<int,int> Router::route_order(Grid& g, const vector<int>& order, SearchMode mode){
     map<int,int> id_to_steps;
-    for(const auto& [id, endpoints] : g.net_points){
-        reset_grid_state(g);
-        Cell *start = endpoints.first, *end = endpoints.second;
-        int steps = use_astar ? astar(g, start, end) : bfs(g, start, end);
+    // windowed() and line_probe() only clear the cells they touched
+    bool touched_only = !frontier_cap && (window_margin >= 0 || mode == SEARCH_LINEPROBE);
+    if (touched_only) reset_grid_state(g);
+    for (int id : order) {
+        if (snapshot && snapshot->cancelled()) break;
+        if (deadline && deadline->expired()) {
+            id_to_steps[id] = NOT_ATTEMPTED;
+            continue;
+        }
+        Cell *start = g.net_points.at(id).first, *end = g.net_points.at(id).second;
+        if (frontier_cap) {
+            TraceSpan span("frontier", "net", id);
+            id_to_steps[id] = frontier(g, start, end);
+            continue;
+        }
+        if (window_margin >= 0 && mode != SEARCH_LINEPROBE) {
+            id_to_steps[id] = windowed(g, start, end, mode);
+            continue;
+        }
+        TraceSpan span(search_name(mode), "net", id);
+        if (touched_only) reset_touched_state();
+        else reset_grid_state(g);
+        int steps = search(g, start, end, mode);
         id_to_steps[id] = steps;
     }    
     return id_to_steps;    
 }
 
+map<int,int> Router::try_orders(Grid& g, int tries, SearchMode mode, unsigned seed){
+    TraceSpan span("try_orders", "tries", tries);
+    vector<int> order;
+    for (const auto& [id, _] : g.net_points) order.push_back(id);
+    // Only the order kept is shown
+    RouteSnapshot* shown = snapshot;
+    snapshot = nullptr;
+
+    mt19937 rng(seed);
+    int base = g.checkpoint();
+    map<int,int> best;
+    unordered_map<int, vector<Cell*>> best_routes;
+    int best_routed = -1;
+    long long best_steps = 0;
+    bool last_is_best = false;
+    for (int t = 0; t < max(tries, 1); ++t) {
+        if (t && ((deadline && deadline->expired()) || (shown && shown->cancelled()))) break;
+        if (t) {
+            shuffle(order.begin(), order.end(), rng);
+            g.rollback(base);
+            base = g.checkpoint();
+        }
+        TraceSpan try_span("net_order", "try", t);
+        map<int,int> result = route_order(g, order, mode);
+        int routed = 0;
+        long long steps = 0;
+        for (const auto& [id, s] : result)
+            if (s > 0) routed++, steps += s;
+        last_is_best = routed > best_routed || (routed == best_routed && steps < best_steps);
+        if (last_is_best) {
+            best_routed = routed, best_steps = steps;
+            best.swap(result);
+            best_routes.clear();
+            for (const auto& [id, s] : best)
+                if (s > 0) best_routes[id] = g.routes.at(id);
+        }
+    }
+
+    // The grid holds the last order tried; otherwise the best routes are replayed on the
+    // state of the checkpoint
+    if (last_is_best) g.release(base);
+    else {
+        g.rollback(base);
+        for (auto& [id, cells] : best_routes) {
+            g.will_write_net(id);
+            for (Cell* c : cells) {
+                g.will_write(*c);
+                c->path_id = id;
+            }
+            g.routes[id] = cells;
+        }
+    }
+
+    snapshot = shown;
+    if (snapshot) snapshot->init(g);
+    return best;
+}
+
+map<int,int> Router::route_regions(Grid& g, const RegionMap& regions, int threads,
+                                   const function<SearchMode(const NetGroup&)>& choose){
+    TraceSpan span("route_regions", "groups", regions.groups.size());
+    for (const NetGroup& group : regions.groups)
+        for (int id : group.nets) {
+            g.will_write_net(id);
+            g.routes[id];
+        }
+
+    // Every thread has its own Router, whose search state only ever covers its groups' cells
+    vector<map<int,int>> results(regions.groups.size());
+    atomic<size_t> next{0};
+    auto work = [&]() {
+        Router r;
+        r.snapshot = snapshot;
+        r.deadline = deadline;
+        r.landmarks = landmarks;
+        for (size_t k; (k = next++) < regions.groups.size();) {
+            const NetGroup& group = regions.groups[k];
+            SearchMode mode = choose(group);
+            TraceSpan group_span("region", "nets", group.nets.size());
+            for (int id : group.nets) {
+                if (snapshot && snapshot->cancelled()) break;
+                if (deadline && deadline->expired()) {
+                    results[k][id] = NOT_ATTEMPTED;
+                    continue;
+                }
+                TraceSpan net_span(search_name(mode), "net", id);
+                r.reset_touched_state();
+                Cell *start = g.net_points.at(id).first, *end = g.net_points.at(id).second;
+                results[k][id] = r.search(g, start, end, mode);
+            }
+            r.reset_touched_state();
+        }
+    };
+    vector<thread> pool;
+    for (int t = 1; t < min<int>(threads, regions.groups.size()); ++t) pool.emplace_back(work);
+    work();
+    for (auto& t : pool) t.join();
+
+    map<int,int> id_to_steps;
+    for (const auto& result : results)
+        id_to_steps.insert(result.begin(), result.end());
+    for (const NetGroup& group : regions.groups)
+        for (int id : group.nets)
+            if (g.routes[id].empty()) g.routes.erase(id);
+    return id_to_steps;
+}
+
+Router::Router(){}
+Router::~Router(){}
+
 int Router::bfs(Grid& g, Cell* start, Cell* end) {
+    long long cells = (long long)g.M * g.N;
+    if (search_threads > 1 && cells >= parallel_bfs_cells && cells < (1LL << 30) && !window_on) {
+        if (!parallel_bfs || parallel_bfs->threads() != search_threads)
+            parallel_bfs.reset(new ParallelBfs(search_threads));
+        int rid = start->path_id;
+        if (parallel_bfs->search(g, start, end, rid, deadline, touched) == NOT_ATTEMPTED)
+            return abandon(rid);
+        return backtrace(g, rid);
+    }
+
     queue<Cell*> q;
     q.push(start);
     int rid = start->path_id;
     start->visited[rid] = true;
+    touched.push_back(start);
+    if (window_on) window_depth[(size_t)start->x * g.N + start->y] = 0;
     while (!q.empty()) {
+        if (out_of_time()) return abandon(rid);
         Cell* cur = q.front();
         q.pop();
+        expanded_cells++;
         if (cur == end) break;
         for (Cell* n : g.get_neighbors(cur)) {
             // (n->is_end && n->path_id == rid): 此鄰居為現在要找的 route 的 ending point
             // (n->is_space && n->path_id == -1): 此鄰居為一般的可走點 (非 end 也非 start)
-            if (!n->visited[rid] && ((n->is_end && n->path_id == rid) || (n->is_space && n->path_id == -1))) {
+            if (!n->visited[rid] && ((n->is_end && n->path_id == rid) || (n->is_space && n->path_id == -1)) && in_window(n)) {
                 n->visited[rid] = true;
                 n->parent = cur;
+                touched.push_back(n);
                 q.push(n);
+                if (window_on)
+                    window_depth[(size_t)n->x * g.N + n->y] = window_depth[(size_t)cur->x * g.N + cur->y] + 1;
             }
         }
     }
+    return finish_search(g, rid);
+}
+
+// Frontier search: nothing is written to the cells but the route found
+int Router::frontier(Grid& g, Cell* start, Cell* end) {
+    int rid = start->path_id;
+    FrontierSearch search(frontier_cap);
+    vector<int> route;
+    int found = search.search(g, rid, start->x * g.N + start->y, end->x * g.N + end->y, deadline, route);
+    frontier_peak = max(frontier_peak, search.peak_bytes);
+    if (found == NOT_ATTEMPTED) return abandon(rid);
+    if (found != 1) {
+        if (found == FrontierSearch::OVER_CAP) over_cap++;
+        if (snapshot) snapshot->commit(rid, -1, vector<Cell*>());
+        return -1;
+    }
+    // Touched, so an edit's reset_touched_state() drops these parents before re-routing
+    start->parent = nullptr;
+    for (size_t k = 1; k < route.size(); ++k) {
+        Cell& c = g.grid[route[k] / g.N][route[k] % g.N];
+        c.parent = &g.grid[route[k - 1] / g.N][route[k - 1] % g.N];
+        touched.push_back(&c);
+    }
+    return backtrace(g, rid);
+}
+
+// Line probes write nothing to the cells either but the route found
+int Router::line_probe(Grid& g, Cell* start, Cell* end) {
+    int rid = start->path_id;
+    LineProbe search(max_probes);
+    vector<int> route;
+    int found = search.search(g, rid, start->x * g.N + start->y, end->x * g.N + end->y, deadline, route);
+    probes += search.probes;
+    if (found == NOT_ATTEMPTED) return abandon(rid);
+    if (found != 1) {
+        probe_fallbacks++;
+        return bfs(g, start, end);
+    }
+    start->parent = nullptr;
+    for (size_t k = 1; k < route.size(); ++k) {
+        Cell& c = g.grid[route[k] / g.N][route[k] % g.N];
+        c.parent = &g.grid[route[k - 1] / g.N][route[k - 1] % g.N];
+        touched.push_back(&c);
+    }
     return backtrace(g, rid);
 }
 
 int Router::backtrace(Grid& g, int rid){
-    Cell *end = g.net_points[rid].second; // endpoint
-    Cell *start = g.net_points[rid].first; // startpoint
+    Cell *end = g.net_points.at(rid).second; // endpoint
+    Cell *start = g.net_points.at(rid).first; // startpoint
     Cell *cur = end;
 
     vector<Cell*> path = {};
@@ -105,17 +358,108 @@ int Router::backtrace(Grid& g, int rid){
     if(cur == start){
         path.push_back(cur);
         for(auto cell : path) {
+            g.will_write(*cell);
             cell->path_id = rid;
         }
+        // route_regions() makes the entries up front, so its threads only look them up
+        g.will_write_net(rid);
+        auto it = g.routes.find(rid);
+        if (it == g.routes.end()) it = g.routes.emplace(rid, vector<Cell*>()).first;
+        it->second.assign(path.rbegin(), path.rend());
+        if (snapshot) snapshot->commit(rid, path.size(), path);
         return path.size();
     }
-    else return -1;
+    if (snapshot) snapshot->commit(rid, -1, vector<Cell*>());
+    return -1;
+}
+
+int Router::finish_search(Grid& g, int rid){
+    if (window_on) {
+        Cell *start = g.net_points.at(rid).first, *cur = g.net_points.at(rid).second;
+        int cells = 1;
+        while (cur && cur != start) cur = cur->parent, cells++;
+        bool found = cur == start;
+        // A failed search only ends for good when it could not leave the window either
+        long long leave = window_exit_bound(g, rid, found);
+        if (found ? cells - 1 > leave : leave != LLONG_MAX) return WINDOW_RETRY;
+    }
+    return backtrace(g, rid);
+}
+
+// Shortest a route of `rid` leaving the window can be: it crosses from some cell b on the
+// window's edge to an open cell o outside, so it is at least dist(start, b) + 1 +
+// manhattan(o, end) long. dist is the BFS depth of the searched cells (the cells BFS has not
+// reached are further away than the end) and the Manhattan distance for A*, whose route
+// found may pass by unsearched ones. Without a route only the searched cells can be left from.
+long long Router::window_exit_bound(Grid& g, int rid, bool found){
+    Cell *start = g.net_points.at(rid).first, *end = g.net_points.at(rid).second;
+    long long best = LLONG_MAX;
+    auto exit = [&](int bx, int by, int ox, int oy) {
+        if (ox < 0 || ox >= g.M || oy < 0 || oy >= g.N) return;
+        const Cell &b = g.grid[bx][by], &o = g.grid[ox][oy];
+        if (!((o.is_end && o.path_id == rid) || (o.is_space && o.path_id == -1))) return;
+        auto v = b.visited.find(rid);
+        bool searched = v != b.visited.end() && v->second;
+        if (!searched && !(found && !window_exact)) return;
+        long long to_b = searched && window_exact ? window_depth[(size_t)bx * g.N + by]
+                                                  : abs(bx - start->x) + abs(by - start->y);
+        best = min(best, to_b + 1 + abs(ox - end->x) + abs(oy - end->y));
+    };
+    for (int x = window[0]; x <= window[1]; ++x) {
+        exit(x, window[2], x, window[2] - 1);
+        exit(x, window[3], x, window[3] + 1);
+    }
+    for (int y = window[2]; y <= window[3]; ++y) {
+        exit(window[0], y, window[0] - 1, y);
+        exit(window[1], y, window[1] + 1, y);
+    }
+    return best;
+}
+
+// Searches inside growing windows around the net, keeping a route as soon as no route
+// leaving the window can be shorter (see window_exit_bound)
+int Router::windowed(Grid& g, Cell* start, Cell* end, SearchMode mode){
+    int x0 = min(start->x, end->x), x1 = max(start->x, end->x);
+    int y0 = min(start->y, end->y), y1 = max(start->y, end->y);
+    window_exact = mode == SEARCH_BFS;
+    if (window_exact) window_depth.resize((size_t)g.M * g.N);
+    for (long long m = window_margin;; m = 2 * m + 1) {
+        window[0] = max<long long>(0, x0 - m), window[1] = min<long long>(g.M - 1, x1 + m);
+        window[2] = max<long long>(0, y0 - m), window[3] = min<long long>(g.N - 1, y1 + m);
+        // Past half the grid, the next window would cost about as much as the whole grid
+        long long area = (long long)(window[1] - window[0] + 1) * (window[3] - window[2] + 1);
+        bool whole = 2 * area >= (long long)g.M * g.N;
+        window_on = !whole;
+        TraceSpan span(search_name(mode), "margin", m);
+        reset_touched_state();
+        int steps = search(g, start, end, mode);
+        window_on = false;
+        if (steps != WINDOW_RETRY) {
+            if (whole) window_fallbacks++;
+            return steps;
+        }
+        window_retries++;
+    }
+}
+
+bool Router::out_of_time(){
+    return deadline && (++expansions & 4095) == 0 && deadline->expired();
+}
+
+// Gives up on a search cut short by the deadline
+int Router::abandon(int rid){
+    if (snapshot) snapshot->commit(rid, NOT_ATTEMPTED, vector<Cell*>());
+    return NOT_ATTEMPTED;
 }
 
 // Heuristic Astar algo
 int Router::astar(Grid& g, Cell* start, Cell* end) {
-    auto heuristic = [end](Cell* a) {
-        return abs(a->x - end->x) + abs(a->y - end->y);
+    const Landmarks* alt = landmarks && !landmarks->empty() ? landmarks : nullptr;
+    int target = end->x * g.N + end->y;
+    auto heuristic = [end, alt, target, &g](Cell* a) {
+        int h = abs(a->x - end->x) + abs(a->y - end->y);
+        if (alt) h = max(h, alt->lower_bound(a->x * g.N + a->y, target));
+        return h;
     };
 
     struct PQElem {
@@ -139,18 +483,20 @@ int Router::astar(Grid& g, Cell* start, Cell* end) {
 
     int rid = start->path_id;
     start->visited[rid] = true;
-    
+    touched.push_back(start);
 
     unordered_map<Cell*, int> g_score;
     g_score[start] = 0;
 
     while (!pq.empty()) {
+        if (out_of_time()) return abandon(rid);
         Cell* cur = pq.top().cell;
         pq.pop();
+        expanded_cells++;
         if (cur == end) break;
 
         for (Cell* n : g.get_neighbors(cur)) {
-            if (!n->visited[rid] && ((n->is_end && n->path_id == rid) || (n->is_space && n->path_id == -1))){
+            if (!n->visited[rid] && ((n->is_end && n->path_id == rid) || (n->is_space && n->path_id == -1)) && in_window(n)){
                 int tentative_g = g_score[cur] + 1;
                 if (!g_score.count(n) || tentative_g < g_score[n]) {
                     g_score[n] = tentative_g;
@@ -158,14 +504,66 @@ int Router::astar(Grid& g, Cell* start, Cell* end) {
                     pq.emplace(f, heuristic(n), n);
                     n->parent = cur;
                     n->visited[rid] = true;
+                    touched.push_back(n);
                 }
             }
         }
     }
 
-    return backtrace(g, start->path_id);
+    return finish_search(g, start->path_id);
+}
+
+
+// Hadlock's algorithm: a route with d detours (steps away from the end) is manhattan + 2d
+// long, so the shortest routes have the fewest detours. The cells are searched by detour
+// number, level d and level d + 1 kept apart instead of in a heap; within a level the cells
+// a step towards the end reached last come first, so the search runs straight at the end
+// while it can.
+int Router::hadlock(Grid& g, Cell* start, Cell* end) {
+    int rid = start->path_id;
+    detours.resize((size_t)g.M * g.N);
+    auto index = [&g](const Cell* c) { return (size_t)c->x * g.N + c->y; };
+    auto to_end = [end](const Cell* c) { return abs(c->x - end->x) + abs(c->y - end->y); };
+
+    vector<Cell*> level = {start}, next;     // detour number d and d + 1
+    start->visited[rid] = true;
+    touched.push_back(start);
+    detours[index(start)] = 0;
+    for (int d = 0; !level.empty() || !next.empty();) {
+        if (level.empty()) {
+            level.swap(next);
+            d++;
+            continue;
+        }
+        if (out_of_time()) return abandon(rid);
+        Cell* cur = level.back();
+        level.pop_back();
+        if (detours[index(cur)] != d) continue;    // since reached with fewer detours
+        expanded_cells++;
+        if (cur == end) break;
+        for (Cell* n : g.get_neighbors(cur)) {
+            if (!((n->is_end && n->path_id == rid) || (n->is_space && n->path_id == -1)) || !in_window(n)) continue;
+            int nd = to_end(n) < to_end(cur) ? d : d + 1;
+            bool seen = n->visited[rid];
+            if (seen && detours[index(n)] <= nd) continue;
+            if (!seen) {
+                n->visited[rid] = true;
+                touched.push_back(n);
+            }
+            detours[index(n)] = nd;
+            n->parent = cur;
+            (nd == d ? level : next).push_back(n);
+        }
+    }
+    return finish_search(g, rid);
 }
 
+int Router::search(Grid& g, Cell* start, Cell* end, SearchMode mode){
+    if (mode == SEARCH_ASTAR) return astar(g, start, end);
+    if (mode == SEARCH_HADLOCK) return hadlock(g, start, end);
+    if (mode == SEARCH_LINEPROBE) return line_probe(g, start, end);
+    return bfs(g, start, end);
+}
 
 void Router::reset_grid_state(Grid& g){
     for (auto& row : g.grid) {
@@ -175,12 +573,36 @@ void Router::reset_grid_state(Grid& g){
             c.parent = nullptr;
         }
     }
+    touched.clear();
+}
+
+void Router::reset_touched_state(){
+    for (Cell* c : touched) {
+        c->visited.clear();
+        c->parent = nullptr;
+    }
+    touched.clear();
+}
+
+void Router::clear(){
+    touched.clear();
+    waiting.clear();
+    watched.clear();
+    expansions = 0;
+    frontier_peak = 0;
+    over_cap = 0;
+    expanded_cells = 0;
+    window_retries = window_fallbacks = 0;
+    probes = 0;
+    probe_fallbacks = 0;
 }
 
 // ILP Algorithm
-map<int,int> Router::route_with_ilp(Grid& g, int max_iteration, double time_limit, int thread_count) {
+map<int,int> Router::route_with_ilp(Grid& g, int max_iteration, double time_limit, int thread_count,
+                                    ComponentSolver* component_solver) {
     map<int,int> id_to_steps;
     set<int> remaining_nets;
+    set<int> attempted;     // nets searched at least once before the deadline
     
     // Initialize all nets
     for (const auto& [id, _] : g.net_points) {
@@ -190,14 +612,29 @@ map<int,int> Router::route_with_ilp(Grid& g, int max_iteration, double time_limi
     // cout << "Starting ILP routing with " << remaining_nets.size() << " nets" << endl;
     // cout << "Time limit: " << time_limit << " seconds, Thread count: " << thread_count << endl;
     
-    ILPSolver solver;
+    unique_ptr<ComponentSolver> fallback;
+    if (!component_solver) {
+        fallback = default_component_solver();
+        component_solver = fallback.get();
+    }
+    ConflictSolver solver(*component_solver);
     solver.set_time_limit(time_limit);
     solver.set_thread_count(thread_count);
+    ilp_stats = ConflictStats();
+
+    // Candidate paths of the current iteration; the arena is reused across iterations
+    PathPool all_paths(g.N);
     
     while (!remaining_nets.empty() && max_iteration) {
+        if (snapshot && snapshot->cancelled()) break;
+        if (deadline && deadline->expired()) break;
+        TraceSpan span("ilp_iteration", "nets", remaining_nets.size());
                 
         // Finding routes for remaining paths.
-        vector<Path> all_paths = find_all_paths(g, remaining_nets);
+        int searched = find_all_paths(g, remaining_nets, all_paths);
+        auto last = remaining_nets.begin();
+        advance(last, searched);
+        attempted.insert(remaining_nets.begin(), last);
         
         if (all_paths.empty()) {
             // cout << "No more paths found for remaining nets" << endl;
@@ -206,8 +643,25 @@ map<int,int> Router::route_with_ilp(Grid& g, int max_iteration, double time_limi
         
         // cout << "Found " << all_paths.size() << " possible paths" << endl;
         
-        // Main ILP to find maximal non-conflicting routes
-        vector<Path> selected_paths = solver.solve(all_paths);
+        // Main ILP to find maximal non-conflicting routes; the solvers return their best
+        // incumbent when the deadline comes first
+        vector<vector<int>> cuts;
+        if (max_cut > 0) {
+            auto t0 = chrono::steady_clock::now();
+            cuts = find_vertex_cuts(g, all_paths, max_cut, 2, search_threads, deadline);
+            ilp_stats.cut_seconds += chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+        }
+        solver.set_cuts(&cuts);
+        if (deadline) solver.set_time_limit(min(time_limit, deadline->remaining()));
+        vector<int> selected_paths = solver.solve(all_paths);
+        ilp_stats.paths += solver.stats.paths;
+        ilp_stats.components += solver.stats.components;
+        ilp_stats.conflict_free += solver.stats.conflict_free;
+        ilp_stats.largest = max(ilp_stats.largest, solver.stats.largest);
+        ilp_stats.cuts += solver.stats.cuts;
+        ilp_stats.cut_constraints += solver.stats.cut_constraints;
+        ilp_stats.proved_by_cuts += solver.stats.proved_by_cuts;
+        ilp_stats.solve_seconds += solver.stats.solve_seconds;
         
         if (selected_paths.empty()) {
             // cout << "ILP solver couldn't find any non-conflicting paths" << endl;
@@ -217,11 +671,13 @@ map<int,int> Router::route_with_ilp(Grid& g, int max_iteration, double time_limi
         // cout << "ILP solver selected " << selected_paths.size() << " paths" << endl;
         
         // Adding the selected routes to grid
-        for (const auto& path : selected_paths) {
+        for (int selected : selected_paths) {
+            PathView path = all_paths[selected];
             apply_path_to_grid(g, path);
             remaining_nets.erase(path.net_id);
-            id_to_steps[path.net_id] = path.cells.size();
-            // cout << "Applied path for net " << path.net_id << " with " << path.cells.size() << " cells" << endl;
+            id_to_steps[path.net_id] = path.size();
+            if (snapshot) snapshot->commit(path.net_id, path.size(), path);
+            // cout << "Applied path for net " << path.net_id << " with " << path.size() << " cells" << endl;
         }
         max_iteration--;
     }
@@ -229,7 +685,7 @@ map<int,int> Router::route_with_ilp(Grid& g, int max_iteration, double time_limi
     // The nets which can't match. (Can't find a route)
     for (int net_id : remaining_nets) {
         // cout << "Failed to route net " << net_id << endl;
-        id_to_steps[net_id] = -1;
+        id_to_steps[net_id] = attempted.count(net_id) ? -1 : NOT_ATTEMPTED;
     }
     
     // cout << "ILP routing completed. Successfully routed " << (g.net_points.size() - remaining_nets.size()) 
@@ -238,80 +694,411 @@ map<int,int> Router::route_with_ilp(Grid& g, int max_iteration, double time_limi
     return id_to_steps;
 }
 
-Path Router::bfs_ilp(Grid& g, Cell* start, Cell* end) {
-    queue<Cell*> q;
-    q.push(start);
-    int rid = start->path_id;
-    start->visited[rid] = true;
-    while (!q.empty()) {
-        Cell* cur = q.front();
-        q.pop();
-        if (cur == end) break;
-        for (Cell* n : g.get_neighbors(cur)) {
-            // (n->is_end && n->path_id == rid): 此鄰居為現在要找的 route 的 ending point
-            // (n->is_space && n->path_id == -1): 此鄰居為一般的可走點 (非 end 也非 start)
-            if (!n->visited[rid] && ((n->is_end && n->path_id == rid) || (n->is_space && n->path_id == -1))) {
-                n->visited[rid] = true;
-                n->parent = cur;
-                q.push(n);
+namespace {
+
+// Search state of one thread in find_all_paths. Cells are linear indices; seen[c] == stamp
+// marks the cells reached by the current search, so nothing is reset between nets.
+struct CandidateSearch {
+    vector<int> seen, parent, queue;
+    int stamp = 0;
+    long long expansions = 0;
+
+    // BFS in the visiting order of Router::bfs against the committed routes only. Adds the
+    // route, end point first, to `paths` and returns 1; 0 if there is none, NOT_ATTEMPTED if
+    // the deadline expired first.
+    int run(const Grid& g, const Cell* start, const Cell* end, const Deadline* deadline, PathPool& paths){
+        int dx[4] = {1, -1, 0, 0};
+        int dy[4] = {0, 0, 1, -1};
+        if (seen.empty()) {
+            seen.assign((size_t)g.M * g.N, 0);
+            parent.assign((size_t)g.M * g.N, -1);
+        }
+        stamp++;
+        int rid = start->path_id;
+        int s = start->x * g.N + start->y, e = end->x * g.N + end->y;
+        queue.assign(1, s);
+        seen[s] = stamp;
+        for (size_t head = 0; head < queue.size() && seen[e] != stamp; ++head) {
+            if ((++expansions & 4095) == 0 && deadline && deadline->expired()) return NOT_ATTEMPTED;
+            int cur = queue[head], x = cur / g.N, y = cur % g.N;
+            for (int dir = 0; dir < 4; ++dir) {
+                int nx = x + dx[dir], ny = y + dy[dir];
+                if (nx < 0 || nx >= g.M || ny < 0 || ny >= g.N) continue;
+                const Cell& n = g.grid[nx][ny];
+                int next = nx * g.N + ny;
+                if (n.is_obstacle || seen[next] == stamp) continue;
+                if ((n.is_end && n.path_id == rid) || (n.is_space && n.path_id == -1)) {
+                    seen[next] = stamp;
+                    parent[next] = cur;
+                    queue.push_back(next);
+                }
             }
         }
+        if (seen[e] != stamp) return 0;
+        paths.begin_path(rid);
+        for (int c = e; c != s; c = parent[c]) paths.push_cell(c);
+        paths.push_cell(s);
+        paths.end_path();
+        return 1;
     }
-    return backtrace_ilp(g, rid);    
+};
+
 }
 
-Path Router::backtrace_ilp(Grid& g, int rid){
+// The searches only read the grid, so the nets are spread over `search_threads` threads, each
+// with its own search state and path arena. The arenas are merged into the pool in net order,
+// so the candidates are the same whatever the thread count.
+int Router::find_all_paths(Grid& g, const set<int>& target_nets, PathPool& all_paths) {
+    TraceSpan span("find_all_paths");
+    all_paths.reset(g.N);
+    vector<int> nets(target_nets.begin(), target_nets.end());
+    vector<pair<Cell*, Cell*>> endpoints;
+    for (int net_id : nets)
+        endpoints.push_back(g.net_points.at(net_id));
 
-    Cell *end = g.net_points[rid].second; // endpoint
-    Cell *start = g.net_points[rid].first; // startpoint
-    Cell *cur = end;
+    vector<int> status(nets.size(), NOT_ATTEMPTED);
+    // found[k]: thread arena and path index of net k's candidate
+    vector<pair<int, int>> found(nets.size(), {-1, -1});
+    int threads = max(1, min<int>(search_threads, nets.size()));
+    vector<PathPool> arenas(threads, PathPool(g.N));
+    vector<long long> expanded(threads, 0);
+    atomic<size_t> next{0};
+    auto work = [&](int t) {
+        CandidateSearch search;
+        for (size_t k; (k = next++) < nets.size();) {
+            if (deadline && deadline->expired()) break;
+            TraceSpan net_span("candidate_search", "net", nets[k]);
+            status[k] = search.run(g, endpoints[k].first, endpoints[k].second, deadline, arenas[t]);
+            if (status[k] == 1) found[k] = {t, (int)arenas[t].size() - 1};
+        }
+        expanded[t] = search.expansions;
+    };
+    vector<thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(work, t);
+    work(0);
+    for (auto& t : pool) t.join();
+    for (long long n : expanded) expanded_cells += n;
 
-    Path p;
-    p.net_id = -1;
-    vector<Cell*> path_temp = {};
-    vector<pair<int, int>> cells;
+    size_t paths = 0, cells = 0;
+    for (const PathPool& arena : arenas) paths += arena.size(), cells += arena.cell_count();
+    all_paths.reserve(paths, cells);
+    // a search cut short by the deadline ends the list
+    size_t searched = 0;
+    for (; searched < nets.size() && status[searched] != NOT_ATTEMPTED; ++searched) {
+        auto [t, i] = found[searched];
+        if (t >= 0) all_paths.add_path(arenas[t][i]);
+    }
+    return searched;
+}
 
-    while (cur != nullptr && cur != start) {
-        path_temp.push_back(cur);
-        cur = cur->parent;
+void Router::apply_path_to_grid(Grid& g, const PathView& path) {
+    g.will_write_net(path.net_id);
+    vector<Cell*>& route = g.routes[path.net_id];
+    route.clear();
+    // path cells run from the end point back to the start point
+    for (int k = path.size() - 1; k >= 0; --k) {
+        Cell& c = g.grid[path.x(k)][path.y(k)];
+        g.will_write(c);
+        c.path_id = path.net_id;
+        route.push_back(&c);
     }
+}
 
-    if(cur == start){
-        path_temp.push_back(cur);
-        for(auto cell : path_temp) {
-            cells.push_back({cell->x, cell->y});
+// Incremental Editing
+void Grid::rip_up(int id, vector<Cell*>& changed){
+    auto it = routes.find(id);
+    if (it == routes.end()) return;
+    will_write_net(id);
+    for (Cell* c : it->second) {
+        if (c->is_space && c->path_id == id) {
+            will_write(*c);
+            c->path_id = -1;
+            changed.push_back(c);
         }
-        p.cells = cells;
-        p.net_id = rid;
-    }   
+    }
+    routes.erase(it);
+}
+
+void Grid::claim_endpoint(Cell& c, int id, bool is_start, set<int>& affected, vector<Cell*>& changed){
+    if (c.path_id != -1) {
+        // the cell was part of another net's route
+        affected.insert(c.path_id);
+        rip_up(c.path_id, changed);
+    }
+    will_write(c);
+    c.is_space = false;
+    c.is_start = is_start;
+    c.is_end = !is_start;
+    c.path_id = id;
+    changed.push_back(&c);
+}
+
+bool Grid::add_obstacle(int x, int y, set<int>& affected, vector<Cell*>& changed){
+    if (!in_bounds(x, y)) return false;
+    Cell& c = grid[x][y];
+    if (c.is_obstacle || c.is_start || c.is_end) return false;
+    if (c.path_id != -1) {
+        affected.insert(c.path_id);
+        rip_up(c.path_id, changed);
+    }
+    will_write(c);
+    c.is_obstacle = true;
+    c.is_space = false;
+    changed.push_back(&c);
+    return true;
+}
 
-    return p;
+bool Grid::remove_obstacle(int x, int y, vector<Cell*>& changed){
+    if (!in_bounds(x, y) || !grid[x][y].is_obstacle) return false;
+    Cell& c = grid[x][y];
+    will_write(c);
+    c.is_obstacle = false;
+    c.is_space = true;
+    c.path_id = -1;
+    changed.push_back(&c);
+    return true;
 }
 
-// This function works like "bfs", but "conflicts" are acceptable (will be determined which path survives by ILP later)
-vector<Path> Router::find_all_paths(Grid& g, const set<int>& target_nets) {
+bool Grid::add_net(int id, int sx, int sy, int ex, int ey, set<int>& affected, vector<Cell*>& changed){
+    if (id < 0 || net_points.count(id) || !in_bounds(sx, sy) || !in_bounds(ex, ey)) return false;
+    if (sx == ex && sy == ey) return false;
+    Cell &s = grid[sx][sy], &e = grid[ex][ey];
+    if (!s.is_space || !e.is_space) return false;
 
-    vector<Path> all_paths;
-    
-    for (int net_id : target_nets) {
-        // cout << "Finding " << net_id << endl;
-        reset_grid_state(g);
-        Cell* start = g.net_points[net_id].first;
-        Cell* end = g.net_points[net_id].second;
-
-        Path p = bfs_ilp(g, start, end);
-        // cout << "candidates: ";
-        if(p.net_id != -1){
-            all_paths.push_back(p);
-            // cout << p.net_id << " ";
-        }
-        // cout << endl;
-    }    
-    return all_paths;
+    claim_endpoint(s, id, true, affected, changed);
+    claim_endpoint(e, id, false, affected, changed);
+    will_write_net(id);
+    net_points[id] = {&s, &e};
+    return true;
 }
 
-void Router::apply_path_to_grid(Grid& g, const Path& path) {
-    for (const auto& [x, y] : path.cells) {
-        g.grid[x][y].path_id = path.net_id;
+bool Grid::remove_net(int id, vector<Cell*>& changed){
+    auto it = net_points.find(id);
+    if (it == net_points.end()) return false;
+    rip_up(id, changed);
+    for (Cell* c : {it->second.first, it->second.second}) {
+        will_write(*c);
+        c->is_start = c->is_end = false;
+        c->is_space = true;
+        c->path_id = -1;
+        changed.push_back(c);
     }
+    will_write_net(id);
+    net_points.erase(it);
+    return true;
+}
+
+bool Grid::move_endpoint(int id, bool is_start, int x, int y, set<int>& affected, vector<Cell*>& changed){
+    auto it = net_points.find(id);
+    if (it == net_points.end() || !in_bounds(x, y) || !grid[x][y].is_space) return false;
+    rip_up(id, changed);
+
+    will_write_net(id);
+    Cell*& slot = is_start ? it->second.first : it->second.second;
+    will_write(*slot);
+    slot->is_start = slot->is_end = false;
+    slot->is_space = true;
+    slot->path_id = -1;
+    changed.push_back(slot);
+
+    slot = &grid[x][y];
+    claim_endpoint(*slot, id, is_start, affected, changed);
+    return true;
+}
+
+// Checkpoints
+int Grid::checkpoint(){
+    if (!journal) journal.reset(new GridJournal());
+    if (journal->tile_level.empty())
+        journal->tile_level.assign((size_t)((M + TILE - 1) / TILE) * ((N + TILE - 1) / TILE), -1);
+    journal->levels.emplace_back();
+    return journal->levels.size() - 1;
+}
+
+void Grid::save_tile(const Cell& c){
+    lock_guard<mutex> lock(journal->lock);
+    int level = journal->levels.size() - 1;
+    int tile = (c.x / TILE) * ((N + TILE - 1) / TILE) + c.y / TILE;
+    if (journal->tile_level[tile] == level) return;
+
+    GridJournal::SavedTile saved{tile, journal->tile_level[tile], {}};
+    int x0 = c.x / TILE * TILE, y0 = c.y / TILE * TILE;
+    for (int i = x0; i < min(M, x0 + TILE); ++i)
+        for (int j = y0; j < min(N, y0 + TILE); ++j) {
+            const Cell& t = grid[i][j];
+            saved.cells.push_back({t.path_id, t.is_obstacle, t.is_start, t.is_end, t.is_space});
+        }
+    journal->tile_level[tile] = level;
+    journal->levels.back().tiles.push_back(move(saved));
+}
+
+void Grid::save_net(int id){
+    lock_guard<mutex> lock(journal->lock);
+    int level = journal->levels.size() - 1;
+    auto at = journal->net_level.find(id);
+    int prev = at == journal->net_level.end() ? -1 : at->second;
+    if (prev == level) return;
+
+    GridJournal::SavedNet saved{id, prev, false, false, {}, {}};
+    auto p = net_points.find(id);
+    if (p != net_points.end()) saved.had_points = true, saved.points = p->second;
+    auto r = routes.find(id);
+    if (r != routes.end()) saved.had_route = true, saved.route = r->second;
+    journal->net_level[id] = level;
+    journal->levels.back().nets.push_back(move(saved));
+}
+
+void Grid::rollback(int id){
+    if (!journal) return;
+    while ((int)journal->levels.size() > max(id, 0)) {
+        GridJournal::Level& top = journal->levels.back();
+        for (const auto& saved : top.tiles) {
+            int tiles_per_row = (N + TILE - 1) / TILE;
+            int x0 = saved.tile / tiles_per_row * TILE, y0 = saved.tile % tiles_per_row * TILE;
+            size_t k = 0;
+            for (int i = x0; i < min(M, x0 + TILE); ++i)
+                for (int j = y0; j < min(N, y0 + TILE); ++j) {
+                    Cell& t = grid[i][j];
+                    const CellState& old = saved.cells[k++];
+                    t.path_id = old.path_id;
+                    t.is_obstacle = old.is_obstacle, t.is_start = old.is_start;
+                    t.is_end = old.is_end, t.is_space = old.is_space;
+                }
+            journal->tile_level[saved.tile] = saved.prev_level;
+        }
+        for (auto& saved : top.nets) {
+            if (saved.had_points) net_points[saved.id] = saved.points;
+            else net_points.erase(saved.id);
+            if (saved.had_route) routes[saved.id] = move(saved.route);
+            else routes.erase(saved.id);
+            if (saved.prev_level == -1) journal->net_level.erase(saved.id);
+            else journal->net_level[saved.id] = saved.prev_level;
+        }
+        journal->levels.pop_back();
+    }
+}
+
+void Grid::release(int id){
+    if (!journal) return;
+    while ((int)journal->levels.size() > max(id, 0))
+        merge_top_level();
+}
+
+// Hands the saved state of the innermost level to the one below, which keeps its own (older)
+// copy where it has one
+void Grid::merge_top_level(){
+    GridJournal::Level top = move(journal->levels.back());
+    journal->levels.pop_back();
+    int below = journal->levels.size() - 1;
+    for (auto& saved : top.tiles) {
+        if (below >= 0 && saved.prev_level != below) {
+            journal->tile_level[saved.tile] = below;
+            journal->levels.back().tiles.push_back(move(saved));
+        }
+        else journal->tile_level[saved.tile] = saved.prev_level;
+    }
+    for (auto& saved : top.nets) {
+        if (below >= 0 && saved.prev_level != below) {
+            journal->net_level[saved.id] = below;
+            journal->levels.back().nets.push_back(move(saved));
+        }
+        else if (saved.prev_level == -1) journal->net_level.erase(saved.id);
+        else journal->net_level[saved.id] = saved.prev_level;
+    }
+}
+
+// Records the cells bounding the region the failed search of `rid` just explored
+// (the touched cells); the net is retried only when one of them is freed.
+void Router::watch_failed(Grid& g, int rid){
+    int dx[4] = {1, -1, 0, 0};
+    int dy[4] = {0, 0, 1, -1};
+    for (Cell* c : touched) {
+        for (int dir = 0; dir < 4; ++dir) {
+            int ni = c->x + dx[dir], nj = c->y + dy[dir];
+            if (ni < 0 || ni >= g.M || nj < 0 || nj >= g.N) continue;
+            Cell* n = &g.grid[ni][nj];
+            if (!(n->is_space && n->path_id == -1))
+                waiting[n].insert(rid);
+        }
+    }
+    watched.insert(rid);
+}
+
+bool Router::apply_edit(Grid& g, const Edit& e, map<int,int>& id_to_steps, SearchMode mode){
+    TraceSpan span("apply_edit");
+    set<int> affected;
+    vector<Cell*> changed;
+    bool frees_cells = false;   // the edit may unblock previously failed nets
+    bool ok = false;
+
+    switch (e.type) {
+    case Edit::ADD_OBSTACLE:
+        ok = g.add_obstacle(e.x, e.y, affected, changed);
+        break;
+    case Edit::REMOVE_OBSTACLE:
+        ok = frees_cells = g.remove_obstacle(e.x, e.y, changed);
+        // paths may have become shorter than the landmark bounds
+        if (ok && landmarks) landmarks->rebuild(g);
+        break;
+    case Edit::ADD_NET:
+        ok = g.add_net(e.net_id, e.x, e.y, e.x2, e.y2, affected, changed);
+        if (ok) affected.insert(e.net_id);
+        break;
+    case Edit::REMOVE_NET:
+        ok = frees_cells = g.remove_net(e.net_id, changed);
+        if (ok) id_to_steps.erase(e.net_id);
+        break;
+    case Edit::MOVE_START:
+    case Edit::MOVE_END:
+        ok = frees_cells = g.move_endpoint(e.net_id, e.type == Edit::MOVE_START, e.x, e.y, affected, changed);
+        if (ok) affected.insert(e.net_id);
+        break;
+    }
+    if (!ok) return false;
+
+    // Ripping up a route frees its cells as well
+    frees_cells = frees_cells || !affected.empty();
+
+    // A failed net can only succeed now if a cell bounding its last search region was freed.
+    // Nets without a recorded boundary (failed during the initial routing) are retried on
+    // any edit that frees cells.
+    set<int> woken;
+    for (Cell* c : changed) {
+        if (!c->is_space || c->path_id != -1) continue;
+        auto it = waiting.find(c);
+        if (it == waiting.end()) continue;
+        woken.insert(it->second.begin(), it->second.end());
+        waiting.erase(it);
+    }
+    if (e.type == Edit::REMOVE_NET) watched.erase(e.net_id);
+
+    // Affected nets first, then the failed nets this edit may have unblocked
+    vector<int> order(affected.begin(), affected.end());
+    for (const auto& [id, steps] : id_to_steps) {
+        if (steps > 0 || affected.count(id)) continue;
+        if (steps == NOT_ATTEMPTED || woken.count(id) || (frees_cells && !watched.count(id)))
+            order.push_back(id);
+    }
+
+    for (int id : order) {
+        if (deadline && deadline->expired()) {
+            id_to_steps[id] = NOT_ATTEMPTED;
+            continue;
+        }
+        reset_touched_state();
+        Cell *start = g.net_points.at(id).first, *end = g.net_points.at(id).second;
+        int steps = search(g, start, end, mode);
+        id_to_steps[id] = steps;
+        if (steps > 0) {
+            watched.erase(id);
+            const vector<Cell*>& route = g.routes.at(id);
+            changed.insert(changed.end(), route.begin(), route.end());
+        }
+        else if (steps == -1) {
+            watch_failed(g, id);
+        }
+    }
+
+    if (snapshot) snapshot->update(g, changed, id_to_steps);
+    return true;
 }
\ No newline at end of file
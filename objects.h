@@ -5,9 +5,13 @@ using namespace std;
 
 #include <vector>
 #include <map>
+#include <memory>
 #include <unordered_map>
 #include <set>
+#include <functional>
+#include <mutex>
 #include "path.h"
+#include "conflict_solver.h"
 
 class Cell{
 public:
@@ -21,6 +25,44 @@ public:
     int path_id = -1;
 };
 
+// One maze edit, applied with Router::apply_edit
+struct Edit {
+    enum Type { ADD_OBSTACLE, REMOVE_OBSTACLE, ADD_NET, REMOVE_NET, MOVE_START, MOVE_END };
+    Type type;
+    int net_id = -1;
+    int x = 0, y = 0;       // edited cell (start cell for ADD_NET)
+    int x2 = 0, y2 = 0;     // end cell for ADD_NET
+};
+
+// Routing state of a cell, saved by Grid checkpoints
+struct CellState {
+    int path_id;
+    bool is_obstacle, is_start, is_end, is_space;
+};
+
+// Undo log behind Grid::checkpoint(): per checkpoint level, the tiles and nets written since,
+// as they were before the first write
+struct GridJournal {
+    struct SavedTile {
+        int tile, prev_level;           // prev_level: level that saved the tile before, -1 for none
+        vector<CellState> cells;
+    };
+    struct SavedNet {
+        int id, prev_level;
+        bool had_points, had_route;
+        pair<Cell*, Cell*> points;
+        vector<Cell*> route;
+    };
+    struct Level {
+        vector<SavedTile> tiles;
+        vector<SavedNet> nets;
+    };
+    vector<Level> levels;
+    vector<int> tile_level;             // deepest level holding tile t, -1 for none
+    unordered_map<int,int> net_level;
+    mutex lock;                         // Router::route_regions() commits from several threads
+};
+
 class Grid{
 public:
     vector<vector<Cell>> grid;
@@ -28,6 +70,9 @@ public:
     // net_points records the starting and ending points
     unordered_map<int, pair<Cell*, Cell*>> net_points;
 
+    // routes records the committed cells of every routed net, from start to end
+    unordered_map<int, vector<Cell*>> routes;
+
     int M = 0, N = 0;
 
     Grid(int m, int n) : grid(m, vector<Cell>(n)), M(m), N(n) {
@@ -38,25 +83,185 @@ public:
 
     Grid(){}
     ~Grid(){}
+    // Copies point into the copy's own cells (search state and checkpoints are not copied)
+    Grid(const Grid& other);
+    Grid& operator=(const Grid& other);
+    Grid(Grid&&) = default;
+    Grid& operator=(Grid&&) = default;
     
     void print(int);
     vector<Cell*> get_neighbors(Cell*);
+
+    // Incremental edits. Each returns false (and changes nothing) when the edit is illegal;
+    // nets whose committed route had to be ripped up are added to `affected` and the cells
+    // whose ownership changed are appended to `changed`.
+    bool add_obstacle(int x, int y, set<int>& affected, vector<Cell*>& changed);
+    bool remove_obstacle(int x, int y, vector<Cell*>& changed);
+    bool add_net(int id, int sx, int sy, int ex, int ey, set<int>& affected, vector<Cell*>& changed);
+    bool remove_net(int id, vector<Cell*>& changed);
+    bool move_endpoint(int id, bool is_start, int x, int y, set<int>& affected, vector<Cell*>& changed);
+    void rip_up(int id, vector<Cell*>& changed);
+
+    // Checkpoints of the routing state: cell ownership and flags, routes and net end points.
+    // checkpoint() is O(1). While a checkpoint is open, the first write to a TILE x TILE tile
+    // or to a net's route saves the old state (copy on write), so rolling back costs only
+    // what changed. Checkpoints nest; ids are their depth.
+    static const int TILE = 16;
+    int checkpoint();
+    // Back to the state at checkpoint `id`, which is closed together with the later ones
+    void rollback(int id);
+    // Closes checkpoint `id` and the later ones, keeping the changes (an enclosing checkpoint
+    // can still roll them back)
+    void release(int id);
+    int checkpoints() const { return journal ? journal->levels.size() : 0; }
+
+    // To be called before writing the routing state of `c` / the route or end points of net `id`
+    void will_write(const Cell& c) { if (journal && !journal->levels.empty()) save_tile(c); }
+    void will_write_net(int id) { if (journal && !journal->levels.empty()) save_net(id); }
+
+private:
+    bool in_bounds(int x, int y) const { return x >= 0 && x < M && y >= 0 && y < N; }
+    // Turns a free (possibly routed-over) cell into an endpoint of net `id`
+    void claim_endpoint(Cell& c, int id, bool is_start, set<int>& affected, vector<Cell*>& changed);
+    void save_tile(const Cell& c);
+    void save_net(int id);
+    void merge_top_level();
+
+    unique_ptr<GridJournal> journal;
 };
 
+// id_to_steps value of a net whose search did not finish before the deadline
+// (-1 means the search finished without finding a route)
+const int NOT_ATTEMPTED = -2;
+
+class RouteSnapshot;
+class Deadline;
+class Landmarks;
+class ParallelBfs;
+struct RegionMap;
+struct NetGroup;
+
+// Search run for each net by Router::route and friends
+enum SearchMode { SEARCH_BFS, SEARCH_ASTAR, SEARCH_HADLOCK, SEARCH_LINEPROBE };
+const char* search_name(SearchMode mode);    // "bfs", "astar", "hadlock", "lineprobe"
+
 class Router{
 public:        
-    map<int,int> route(Grid& g, bool use_astar = false);
+    Router();
+    ~Router();
+
+
+    // When set, every committed net is published here (used by the GUI while routing runs)
+    RouteSnapshot* snapshot = nullptr;
+    // When set, searches stop once it expires and the nets left over are marked NOT_ATTEMPTED
+    const Deadline* deadline = nullptr;
+    // When set, astar() also uses these landmark lower bounds (rebuilt by apply_edit when an
+    // obstacle is removed)
+    Landmarks* landmarks = nullptr;
+    // bfs() searches level by level on `search_threads` threads on grids of at least
+    // `parallel_bfs_cells` cells (see parallel_bfs.h); the routes are the sequential ones.
+    // find_all_paths() searches that many nets at a time.
+    int search_threads = 1;
+    long long parallel_bfs_cells = 1 << 20;
+    // route_with_ilp() looks for vertex cuts of up to `max_cut` cells around the candidates
+    // before solving (see cut_analysis.h); 0 turns the pre-analysis off
+    int max_cut = 3;
+    // When not 0, route() searches with FrontierSearch (see frontier_search.h), whose frontier
+    // layers are kept under `frontier_cap` bytes (the grid is not counted); nets that would
+    // need more fail and are counted in `over_cap`. `frontier_peak` is the largest seen.
+    size_t frontier_cap = 0;
+    size_t frontier_peak = 0;
+    int over_cap = 0;
+    // When >= 0, route() first searches each net inside its end points' bounding box grown by
+    // `window_margin` cells. A route found there that no route leaving the window could beat
+    // is kept; otherwise the margin is doubled (plus one) until the window covers the grid.
+    // BFS routes keep their full-grid lengths. Line probes do not use windows.
+    int window_margin = -1;
+    long long expanded_cells = 0;   // cells taken off the queue by bfs(), astar(), hadlock() and
+                                    // the ILP candidate searches
+    int window_retries = 0;         // searches repeated with a larger window
+    int window_fallbacks = 0;       // nets whose last window was the whole grid
+    // line_probe() gives up after `max_probes` lines (0 for no limit) and routes the net with
+    // bfs() instead, like the nets it could not connect; counted in `probe_fallbacks`
+    long long max_probes = 1 << 20;
+    long long probes = 0;           // lines probed by line_probe()
+    int probe_fallbacks = 0;
+
+    map<int,int> route(Grid& g, SearchMode mode = SEARCH_BFS);
+    // Routes the nets of `order` in that order (route() uses g.net_points order)
+    map<int,int> route_order(Grid& g, const vector<int>& order, SearchMode mode = SEARCH_BFS);
+    // Explore and commit: routes `tries` net orders, g.net_points order first and then shuffles
+    // drawn from `seed`, each from a checkpoint of g, and keeps the one with the most routed
+    // nets, then the fewest steps. Tries stop at the deadline.
+    map<int,int> try_orders(Grid& g, int tries, SearchMode mode = SEARCH_BFS, unsigned seed = 1);
+    // Routes the net groups of `regions` (see regions.h) on `threads` threads, each group with
+    // the search choose(group) picks. With the same search for every group the routes are
+    // those of route().
+    map<int,int> route_regions(Grid& g, const RegionMap& regions, int threads,
+                               const function<SearchMode(const NetGroup&)>& choose);
+    // One net with the search of `mode`
+    int search(Grid& g, Cell* start, Cell* end, SearchMode mode);
     int bfs(Grid& g, Cell* start, Cell* end);
     int astar(Grid& g, Cell* start, Cell* end);
+    // Hadlock's minimum detour router: shortest routes like bfs(), searched in order of the
+    // number of steps away from the end, each level depth first
+    int hadlock(Grid& g, Cell* start, Cell* end);
+    // Mikami-Tabuchi line probes (see line_probe.h): few bends, not always the shortest route
+    int line_probe(Grid& g, Cell* start, Cell* end);
+    int frontier(Grid& g, Cell* start, Cell* end);
+    int windowed(Grid& g, Cell* start, Cell* end, SearchMode mode);
     int backtrace(Grid& g, int r_id);
     void reset_grid_state(Grid& g);
 
+    // Incremental re-routing: applies `e` to the grid, rips up only the nets it affects and
+    // re-routes them together with the previously failed nets. Returns false if `e` is illegal.
+    bool apply_edit(Grid& g, const Edit& e, map<int,int>& id_to_steps, SearchMode mode = SEARCH_BFS);
+    // Clears the search state of the cells visited since the last reset
+    void reset_touched_state();
+    // Forgets everything tied to the last grid, so the Router can be reused on another maze
+    void clear();
+
     // For ILP
-    map<int,int> route_with_ilp(Grid& g, int max_iteration = 1, double time_limit = 30.0, int thread_count = 1);
-    vector<Path> find_all_paths(Grid& g, const set<int>& target_nets);
-    void apply_path_to_grid(Grid& g, const Path& path);
-    Path bfs_ilp(Grid& g, Cell* start, Cell* end);
-    Path backtrace_ilp(Grid& g, int rid);
+    // Conflict components are solved with `component_solver` (default_component_solver() when nullptr) on
+    // `thread_count` threads, sharing `time_limit` seconds per iteration.
+    map<int,int> route_with_ilp(Grid& g, int max_iteration = 1, double time_limit = 30.0, int thread_count = 1,
+                                ComponentSolver* component_solver = nullptr);
+    // Decomposition statistics summed over the ILP iterations of the last route_with_ilp
+    ConflictStats ilp_stats;
+    // Returns how many of `target_nets` (in order) were searched before the deadline
+    int find_all_paths(Grid& g, const set<int>& target_nets, PathPool& all_paths);
+    void apply_path_to_grid(Grid& g, const PathView& path);
+
+private:
+    void watch_failed(Grid& g, int rid);
+    // Polled by the searches; only reads the clock every few thousand expansions
+    bool out_of_time();
+    int abandon(int rid);
+    // Ends bfs()/astar()/hadlock(): commits the route, or returns WINDOW_RETRY when a larger window
+    // could still give a shorter one
+    int finish_search(Grid& g, int rid);
+    long long window_exit_bound(Grid& g, int rid, bool found);
+    bool in_window(const Cell* c) const {
+        return !window_on || (c->x >= window[0] && c->x <= window[1] && c->y >= window[2] && c->y <= window[3]);
+    }
+    static const int WINDOW_RETRY = -4;
+
+    long long expansions = 0;
+    unique_ptr<ParallelBfs> parallel_bfs;
+
+    // Window of the current windowed() search: x0, x1, y0, y1 (inclusive). With
+    // window_exact, bfs() keeps the depth of the cells it reaches in window_depth.
+    bool window_on = false, window_exact = false;
+    int window[4] = {0, 0, 0, 0};
+    vector<int> window_depth;
+    // Detour numbers of hadlock(), valid for the cells it visited
+    vector<int> detours;
+
+    // Cells whose visited/parent state was written by a search
+    vector<Cell*> touched;
+    // Failed nets waiting for one of the blocking cells around their search region to be freed
+    unordered_map<Cell*, set<int>> waiting;
+    set<int> watched;
 };
 
 #endif
@@ -0,0 +1,260 @@
+#include "parallel_bfs.h"
+#include "deadline.h"
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+// Levels with a smaller frontier are not worth waking the other threads for
+static const size_t PARALLEL_FRONTIER = 2048;
+// Direction switch thresholds of Beamer et al.: bottom-up once the frontier outgrows
+// 1/ALPHA of the unvisited cells, top-down again once it is shrinking and below 1/BETA of
+// the open cells
+static const size_t ALPHA = 14, BETA = 24;
+
+// Threads kept for the whole search, running one phase of a level at a time
+class WorkerPool {
+public:
+    explicit WorkerPool(int threads){
+        for (int t = 1; t < threads; ++t) workers.emplace_back(&WorkerPool::loop, this, t);
+    }
+    ~WorkerPool(){
+        {
+            lock_guard<mutex> guard(lock);
+            stop = true;
+        }
+        start.notify_all();
+        for (auto& w : workers) w.join();
+    }
+
+    int size() const { return workers.size() + 1; }
+
+    // Runs task(t) for every thread t (the caller is thread 0) and waits for all of them
+    void run(const function<void(int)>& task){
+        if (workers.empty()) {
+            task(0);
+            return;
+        }
+        {
+            lock_guard<mutex> guard(lock);
+            current = &task;
+            running = workers.size();
+            generation++;
+        }
+        start.notify_all();
+        task(0);
+        unique_lock<mutex> guard(lock);
+        done.wait(guard, [&]() { return running == 0; });
+    }
+
+private:
+    void loop(int t){
+        uint64_t seen = 0;
+        while (true) {
+            const function<void(int)>* task;
+            {
+                unique_lock<mutex> guard(lock);
+                start.wait(guard, [&]() { return stop || generation != seen; });
+                if (stop) return;
+                seen = generation;
+                task = current;
+            }
+            (*task)(t);
+            lock_guard<mutex> guard(lock);
+            if (--running == 0) done.notify_one();
+        }
+    }
+
+    mutex lock;
+    condition_variable start, done;
+    const function<void(int)>* current = nullptr;
+    uint64_t generation = 0;
+    int running = 0;
+    bool stop = false;
+    vector<thread> workers;
+};
+
+ParallelBfs::ParallelBfs(int threads) : pool(new WorkerPool(max(1, threads))) {
+    next.resize(pool->size());
+}
+
+ParallelBfs::~ParallelBfs(){}
+
+int ParallelBfs::threads() const {
+    return pool->size();
+}
+
+void ParallelBfs::resize(const Grid& g){
+    if (g.M == M && g.N == N) return;
+    M = g.M, N = g.N;
+    size_t total = (size_t)M * N;
+    open.assign(total, 0);
+    level.assign(total, -1);
+    pos.assign(total, 0);
+    claim.reset(new atomic<uint32_t>[total]);
+    for (size_t c = 0; c < total; ++c) claim[c].store(UNCLAIMED, memory_order_relaxed);
+}
+
+// Every frontier cell proposes itself as the parent of its unvisited neighbours; the
+// smallest (position, direction) wins, as in the sequential queue
+void ParallelBfs::top_down(int t, int T, int L){
+    size_t lo = level_start[L], F = level_start[L + 1] - lo;
+    for (size_t i = F * t / T; i < F * (t + 1) / T; ++i) {
+        int c = order[lo + i], x = c / N, y = c % N;
+        for (int dir = 0; dir < 4; ++dir) {
+            int n = neighbor(c, x, y, dir);
+            if (n < 0 || !open[n] || level[n] != -1) continue;
+            uint32_t key = i * 4 + dir;
+            uint32_t cur = claim[n].load(memory_order_relaxed);
+            while (key < cur && !claim[n].compare_exchange_weak(cur, key, memory_order_relaxed)) {}
+        }
+    }
+}
+
+// Every unvisited cell picks its smallest (position, direction) neighbour in the frontier
+void ParallelBfs::bottom_up(int t, int T, int L){
+    vector<int>& cells = next[t];
+    for (size_t k = 0; k < cells.size(); ++k) {
+        int c = cells[k], x = c / N, y = c % N;
+        uint32_t best = UNCLAIMED;
+        for (int dir = 0; dir < 4; ++dir) {
+            int n = neighbor(c, x, y, dir);
+            if (n < 0 || level[n] != L) continue;
+            uint32_t key = pos[n] * 4 + (dir ^ 1);
+            if (key < best) best = key;
+        }
+        if (best != UNCLAIMED) claim[c].store(best, memory_order_relaxed);
+    }
+}
+
+// Gathers the cells won by this thread's part of the frontier, in frontier order
+void ParallelBfs::collect(int t, int T, int L){
+    size_t lo = level_start[L], F = level_start[L + 1] - lo;
+    vector<int>& won = next[t];
+    won.clear();
+    for (size_t i = F * t / T; i < F * (t + 1) / T; ++i) {
+        int c = order[lo + i], x = c / N, y = c % N;
+        for (int dir = 0; dir < 4; ++dir) {
+            int n = neighbor(c, x, y, dir);
+            if (n >= 0 && open[n] && level[n] == -1 && claim[n].load(memory_order_relaxed) == i * 4 + dir)
+                won.push_back(n);
+        }
+    }
+}
+
+int ParallelBfs::search(Grid& g, Cell* start, Cell* end, int rid, const Deadline* deadline, vector<Cell*>& touched){
+    resize(g);
+    const int T = pool->size();
+    const int s = start->x * N + start->y, e = end->x * N + end->y;
+    bottom_up_levels = 0;
+
+    vector<size_t> counts(T, 0);
+    pool->run([&](int t) {
+        for (int x = M * t / T; x < M * (t + 1) / T; ++x)
+            for (int y = 0; y < N; ++y) {
+                const Cell& c = g.grid[x][y];
+                bool ok = !c.is_obstacle && ((c.is_end && c.path_id == rid) || (c.is_space && c.path_id == -1));
+                open[x * N + y] = ok;
+                counts[t] += ok;
+            }
+    });
+    size_t open_total = 0;
+    for (size_t k : counts) open_total += k;
+
+    order.assign(1, s);
+    level_start.assign({0, 1});
+    level[s] = 0;
+    pos[s] = 0;
+
+    int result = 0;
+    bool bottom = false;
+    size_t last_F = 0;
+    vector<int> unvisited;  // superset of the unvisited open cells, built on the first bottom-up level
+    bool have_unvisited = false;
+    for (int L = 0;; ++L) {
+        size_t F = level_start[L + 1] - level_start[L];
+        if (F == 0) break;
+        if (deadline && deadline->expired()) {
+            result = NOT_ATTEMPTED;
+            break;
+        }
+        size_t left = open_total - min(open_total, order.size() - 1);
+        if (!bottom && F * ALPHA > left) bottom = true;
+        else if (bottom && F * BETA < open_total && F < last_F) bottom = false;
+        last_F = F;
+
+        int threads = F >= PARALLEL_FRONTIER || bottom ? T : 1;
+        if (bottom) {
+            bottom_up_levels++;
+            if (!have_unvisited) {
+                for (size_t c = 0; c < open.size(); ++c)
+                    if (open[c] && level[c] == -1) unvisited.push_back(c);
+                have_unvisited = true;
+            }
+            else {
+                unvisited.erase(remove_if(unvisited.begin(), unvisited.end(), [&](int c) { return level[c] != -1; }),
+                                unvisited.end());
+            }
+            // bottom_up() reads its share of the cells from next[t]
+            for (int t = 0; t < T; ++t)
+                next[t].assign(unvisited.begin() + unvisited.size() * t / T, unvisited.begin() + unvisited.size() * (t + 1) / T);
+            pool->run([&](int t) { bottom_up(t, T, L); });
+            pool->run([&](int t) { collect(t, T, L); });
+        }
+        else if (threads > 1) {
+            pool->run([&](int t) { top_down(t, T, L); });
+            pool->run([&](int t) { collect(t, T, L); });
+        }
+        else {
+            top_down(0, 1, L);
+            collect(0, 1, L);
+        }
+
+        // Lay the next level out in frontier order
+        size_t base = order.size(), total = 0;
+        vector<size_t> offset(threads);
+        for (int t = 0; t < threads; ++t) offset[t] = total, total += next[t].size();
+        order.resize(base + total);
+        auto place = [&](int t) {
+            for (size_t j = 0; j < next[t].size(); ++j) {
+                int n = next[t][j];
+                order[base + offset[t] + j] = n;
+                level[n] = L + 1;
+                pos[n] = offset[t] + j;
+            }
+        };
+        if (threads > 1) pool->run(place);
+        else place(0);
+        level_start.push_back(order.size());
+
+        if (level[e] != -1) {
+            result = 1;
+            break;
+        }
+    }
+
+    if (result == 1) {
+        for (int c = e; c != s;) {
+            int L = level[c];
+            int parent = order[level_start[L - 1] + (claim[c].load(memory_order_relaxed) >> 2)];
+            g.grid[c / N][c % N].parent = &g.grid[parent / N][parent % N];
+            c = parent;
+        }
+    }
+
+    // Hand the visited cells to the Router and clean up for the next search
+    size_t first = touched.size();
+    touched.resize(first + order.size());
+    pool->run([&](int t) {
+        for (size_t k = order.size() * t / T; k < order.size() * (t + 1) / T; ++k) {
+            int c = order[k];
+            touched[first + k] = &g.grid[c / N][c % N];
+            level[c] = -1;
+            claim[c].store(UNCLAIMED, memory_order_relaxed);
+        }
+    });
+    return result;
+}
@@ -0,0 +1,65 @@
+#ifndef _PARALLEL_BFS_H
+#define _PARALLEL_BFS_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "objects.h"
+
+using namespace std;
+
+class Deadline;
+class WorkerPool;
+
+// Level-synchronous BFS for single long searches on large grids, used by Router::bfs.
+//
+// Each level's frontier is split among the threads. A cell of the next level is claimed with
+// an atomic minimum on (position of its parent in the frontier, direction), so it ends up with
+// the parent the sequential BFS would have given it, and the next frontier is laid out in the
+// sequential queue order: the routes are exactly the ones of the sequential BFS.
+//
+// Levels whose frontier is large compared to the unvisited cells are expanded bottom-up (every
+// unvisited cell looks for a neighbour in the frontier) instead of top-down.
+class ParallelBfs {
+public:
+    explicit ParallelBfs(int threads);
+    ~ParallelBfs();
+
+    // Searches from `start` to `end` for net `rid`. Returns 1 and sets Cell::parent along the
+    // route if `end` was reached, 0 if not, NOT_ATTEMPTED if `deadline` expired first. Every
+    // visited cell is appended to `touched`.
+    int search(Grid& g, Cell* start, Cell* end, int rid, const Deadline* deadline, vector<Cell*>& touched);
+
+    int threads() const;
+    int bottom_up_levels = 0;   // levels of the last search expanded bottom-up
+
+private:
+    static const uint32_t UNCLAIMED = 0xffffffffu;
+
+    void resize(const Grid& g);
+    // Neighbour of cell c = (x, y) in the order of Grid::get_neighbors (x + 1, x - 1, y + 1,
+    // y - 1), -1 outside the grid. The direction back from the neighbour is dir ^ 1.
+    int neighbor(int c, int x, int y, int dir) const {
+        switch (dir) {
+        case 0: return x + 1 < M ? c + N : -1;
+        case 1: return x > 0 ? c - N : -1;
+        case 2: return y + 1 < N ? c + 1 : -1;
+        default: return y > 0 ? c - 1 : -1;
+        }
+    }
+    void top_down(int t, int T, int L);
+    void bottom_up(int t, int T, int L);
+    void collect(int t, int T, int L);
+
+    unique_ptr<WorkerPool> pool;
+    int M = 0, N = 0;
+    vector<uint8_t> open;                   // cell may be entered by the current net
+    vector<int> level, pos;                 // BFS level (-1: unvisited) and position within it
+    unique_ptr<atomic<uint32_t>[]> claim;   // pos of parent * 4 + direction from the parent
+    vector<int> order;                      // visited cells, level after level
+    vector<size_t> level_start;             // start of every level in `order`
+    vector<vector<int>> next;               // per thread: cells won, in frontier order
+};
+
+#endif
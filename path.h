@@ -3,12 +3,65 @@
 
 #include <vector>
 #include <utility>
+#include <cstddef>
 
 using namespace std;
 
-struct Path {
-    int net_id;
-    vector<pair<int, int>> cells;  // (x, y) coordinates
+// Read-only view of one candidate path stored in a PathPool.
+// Cells are linear indices (x * N + y), listed from the end point back to the start point.
+struct PathView {
+    int net_id = -1;
+    const int* cells = nullptr;
+    int length = 0;
+    int N = 1;  // row stride used to decode the indices
+
+    int size() const { return length; }
+    int operator[](int k) const { return cells[k]; }
+    int x(int k) const { return cells[k] / N; }
+    int y(int k) const { return cells[k] % N; }
+    const int* begin() const { return cells; }
+    const int* end() const { return cells + length; }
+};
+
+// Candidate paths of one ILP iteration, stored back to back in a single arena.
+// Views handed out by operator[] stay valid until the pool is appended to or reset.
+class PathPool {
+public:
+    explicit PathPool(int n = 1) : N(n) {}
+
+    void reset(int n) { N = n; arena.clear(); entries.clear(); }
+    void reserve(size_t paths, size_t cells) { entries.reserve(paths); arena.reserve(cells); }
+
+    // Cells of a new path (linear indices) are pushed between begin_path() and end_path()
+    void begin_path(int net_id) { entries.push_back({net_id, arena.size(), 0}); }
+    void push_cell(int cell) { arena.push_back(cell); }
+    void end_path() { entries.back().length = arena.size() - entries.back().offset; }
+    // Copy of a path of another pool with the same stride
+    void add_path(const PathView& path) {
+        entries.push_back({path.net_id, arena.size(), path.length});
+        arena.insert(arena.end(), path.begin(), path.end());
+    }
+
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    size_t cell_count() const { return arena.size(); }
+    int stride() const { return N; }
+
+    PathView operator[](size_t i) const {
+        const Entry& e = entries[i];
+        return PathView{e.net_id, arena.data() + e.offset, e.length, N};
+    }
+
+private:
+    struct Entry {
+        int net_id;
+        size_t offset;
+        int length;
+    };
+
+    int N;
+    vector<int> arena;
+    vector<Entry> entries;
 };
 
-#endif 
\ No newline at end of file
+#endif
@@ -0,0 +1,148 @@
+#include "portfolio.h"
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+using namespace std;
+
+namespace {
+
+// Candidates in order, each kept unless it conflicts with one kept before
+vector<int> first_fit(const vector<vector<int>>& adj, const vector<int>& members){
+    vector<char> in(members.size(), 0);
+    vector<int> chosen;
+    for (size_t i = 0; i < members.size(); ++i) {
+        bool free = true;
+        for (int v : adj[i]) free = free && !in[v];
+        if (!free) continue;
+        in[i] = 1;
+        chosen.push_back(members[i]);
+    }
+    return chosen;
+}
+
+// Iterated local search for a large independent set of the conflict graph (after Andrade,
+// Resende and Werneck): (1,2)-swaps take out one chosen path for two it alone kept out
+struct LocalSearch {
+    const vector<vector<int>>& adj;     // sorted, as conflict_graph() builds them
+    vector<char> in;
+    vector<int> tight;                  // chosen neighbours of every path
+    vector<int> candidates;
+    int size = 0;
+    mt19937 rng{1};
+
+    explicit LocalSearch(const vector<vector<int>>& adj) : adj(adj), in(adj.size(), 0), tight(adj.size(), 0) {}
+
+    void add(int v){
+        in[v] = 1, size++;
+        for (int w : adj[v]) tight[w]++;
+    }
+    void remove(int v){
+        in[v] = 0, size--;
+        for (int w : adj[v]) tight[w]--;
+    }
+    void fill(){
+        for (size_t v = 0; v < adj.size(); ++v)
+            if (!in[v] && tight[v] == 0) add(v);
+    }
+    void load(const vector<char>& set){
+        for (size_t v = 0; v < adj.size(); ++v)
+            if (in[v] && !set[v]) remove(v);
+        for (size_t v = 0; v < adj.size(); ++v)
+            if (!in[v] && set[v]) add(v);
+    }
+
+    bool two_improve(){
+        for (size_t x = 0; x < adj.size(); ++x) {
+            if (!in[x]) continue;
+            candidates.clear();
+            for (int v : adj[x])
+                if (tight[v] == 1) candidates.push_back(v);
+            for (size_t i = 0; i < candidates.size(); ++i)
+                for (size_t j = i + 1; j < candidates.size(); ++j) {
+                    int a = candidates[i], b = candidates[j];
+                    if (binary_search(adj[a].begin(), adj[a].end(), b)) continue;
+                    remove(x);
+                    add(a), add(b);
+                    fill();
+                    return true;
+                }
+        }
+        return false;
+    }
+
+    // Forces a random path in, taking out the ones it conflicts with
+    void perturb(){
+        int v = uniform_int_distribution<int>(0, adj.size() - 1)(rng);
+        if (in[v]) return;
+        for (int w : adj[v])
+            if (in[w]) remove(w);
+        add(v);
+        fill();
+    }
+};
+
+void local_search(const vector<vector<int>>& adj, const vector<int>& members, SharedIncumbent& shared,
+                  chrono::steady_clock::time_point deadline){
+    TraceSpan span("local_search", "paths", members.size());
+    unordered_map<int, int> position;
+    for (size_t i = 0; i < members.size(); ++i) position[members[i]] = i;
+    auto to_set = [&](const vector<int>& chosen) {
+        vector<char> set(members.size(), 0);
+        for (int p : chosen) set[position[p]] = 1;
+        return set;
+    };
+
+    LocalSearch ls(adj);
+    vector<char> best = to_set(shared.best());
+    int best_size = shared.size();
+    ls.load(best);
+    // Gives up after this many perturbations without a better choice
+    const int max_stall = 1000;
+    for (int stall = 0; stall < max_stall && !shared.stopped() && chrono::steady_clock::now() < deadline;) {
+        while (ls.two_improve()) {}
+        if (ls.size > best_size) {
+            best = ls.in, best_size = ls.size;
+            vector<int> chosen;
+            for (size_t i = 0; i < members.size(); ++i)
+                if (best[i]) chosen.push_back(members[i]);
+            shared.offer(chosen, SharedIncumbent::LOCAL_SEARCH);
+            stall = 0;
+        }
+        else stall++;
+        // The exact solver may be ahead
+        if (shared.size() > best_size) {
+            best = to_set(shared.best()), best_size = count(best.begin(), best.end(), 1);
+            ls.load(best);
+        }
+        else if (ls.size < best_size) ls.load(best);
+        ls.perturb();
+    }
+}
+
+}
+
+vector<int> PortfolioSolver::solve(const PathPool& paths, const vector<int>& members, const vector<CutConstraint>& cuts,
+                                   double time_limit, int worker){
+    SharedIncumbent shared(cut_bound(members.size(), cuts), gap);
+    vector<vector<int>> adj = conflict_graph(paths, members);
+    shared.offer(first_fit(adj, members), SharedIncumbent::GREEDY);
+    shared.offer(greedy_disjoint(paths, members), SharedIncumbent::GREEDY);
+    if (shared.stopped()) return shared.best();
+
+    TraceSpan span("portfolio", "paths", members.size());
+    stats.raced++;
+    auto deadline = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(
+                        chrono::duration<double>(time_limit));
+    thread helper(local_search, cref(adj), cref(members), ref(shared), deadline);
+    exact.race(paths, members, cuts, time_limit, worker, shared);
+    helper.join();
+
+    stats.won[shared.found_by()]++;
+    if (shared.proven()) stats.proven++;
+    else if (shared.stopped()) stats.within_gap++;
+    return shared.best();
+}
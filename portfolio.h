@@ -0,0 +1,41 @@
+#ifndef _PORTFOLIO_H
+#define _PORTFOLIO_H
+
+#include <atomic>
+#include "conflict_solver.h"
+
+using namespace std;
+
+// Racing solver portfolio for the ILP mode.
+//
+// Each conflict component is solved by the exact solver (Gurobi, or LocalSolver without it)
+// and, on a second thread, by a local search, both sharing one SharedIncumbent. A first-fit
+// choice in candidate order (what sequential routing would keep) and the minimum-degree greedy
+// go first, so the exact solver starts from the better one (a MIP start for Gurobi). The local
+// search improves the best with (1,2)-swaps and random perturbations and publishes every
+// improvement; the exact solver picks them up and publishes its own. The race ends as soon as
+// the best is proven optimal (it reaches the bound of the cuts or of the exact solver) or is
+// within `gap` of that bound, and otherwise when the exact solver is done and the local search
+// stops improving, or at the time limit.
+class PortfolioSolver : public ComponentSolver {
+public:
+    explicit PortfolioSolver(ComponentSolver& exact, double gap = 0) : exact(exact), gap(gap) {}
+
+    void prepare(int workers, int threads) override { exact.prepare(workers, threads); }
+    vector<int> solve(const PathPool& paths, const vector<int>& members, const vector<CutConstraint>& cuts,
+                      double time_limit, int worker) override;
+
+    // Summed over every solve() since construction
+    struct Stats {
+        atomic<int> raced{0};           // components the first choices did not settle
+        atomic<int> won[3] = {};        // raced components by who found the best (SharedIncumbent::Finder)
+        atomic<int> proven{0};          // raced components whose best was proven optimal
+        atomic<int> within_gap{0};      // raced components stopped within the gap, not proven
+    } stats;
+
+private:
+    ComponentSolver& exact;
+    double gap;
+};
+
+#endif
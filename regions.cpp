@@ -0,0 +1,58 @@
+#include "regions.h"
+#include "trace.h"
+#include <numeric>
+
+using namespace std;
+
+RegionMap find_regions(const Grid& g){
+    TraceSpan span("find_regions");
+    RegionMap map;
+    const int M = g.M, N = g.N;
+    map.label.assign((size_t)M * N, -1);
+
+    // Flood fill every region
+    vector<long long> size;
+    vector<int> stack;
+    for (int s = 0; s < M * N; ++s) {
+        if (map.label[s] != -1 || g.grid[s / N][s % N].is_obstacle) continue;
+        int id = map.regions++;
+        size.push_back(0);
+        map.label[s] = id;
+        stack.assign(1, s);
+        while (!stack.empty()) {
+            int c = stack.back(), x = c / N, y = c % N;
+            stack.pop_back();
+            size[id]++;
+            int next[4] = {x + 1 < M ? c + N : -1, x > 0 ? c - N : -1, y + 1 < N ? c + 1 : -1, y > 0 ? c - 1 : -1};
+            for (int n : next) {
+                if (n < 0 || map.label[n] != -1 || g.grid[n / N][n % N].is_obstacle) continue;
+                map.label[n] = id;
+                stack.push_back(n);
+            }
+        }
+    }
+
+    // Regions joined by a net with its end points in both
+    vector<int> parent(map.regions);
+    iota(parent.begin(), parent.end(), 0);
+    auto find = [&](int a) {
+        while (parent[a] != a) a = parent[a] = parent[parent[a]];
+        return a;
+    };
+    auto region = [&](const Cell* c) { return map.label[c->x * N + c->y]; };
+    for (const auto& [id, endpoints] : g.net_points)
+        parent[find(region(endpoints.first))] = find(region(endpoints.second));
+
+    vector<int> group_of(map.regions, -1);
+    for (const auto& [id, endpoints] : g.net_points) {
+        int root = find(region(endpoints.first));
+        if (group_of[root] == -1) {
+            group_of[root] = map.groups.size();
+            map.groups.emplace_back();
+        }
+        map.groups[group_of[root]].nets.push_back(id);
+    }
+    for (int r = 0; r < map.regions; ++r)
+        if (group_of[find(r)] != -1) map.groups[group_of[find(r)]].cells += size[r];
+    return map;
+}
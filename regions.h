@@ -0,0 +1,30 @@
+#ifndef _REGIONS_H
+#define _REGIONS_H
+
+#include <vector>
+#include "objects.h"
+
+using namespace std;
+
+// Decomposition of a maze into regions separated by obstacle walls.
+//
+// A region is a 4-connected set of cells that are not obstacles (free cells and end points).
+// A search only ever reads or writes non-obstacle cells next to the cells it enters, so nets
+// whose end points lie in different regions never touch the same cell: each group of nets
+// can be routed on its own thread, and in the relative order of the sequential Router::route
+// the routes are the sequential ones.
+struct NetGroup {
+    vector<int> nets;       // in g.net_points order
+    long long cells = 0;    // cells of the group's regions
+};
+
+struct RegionMap {
+    vector<int> label;          // per cell (x * N + y): region, -1 for obstacles
+    int regions = 0;
+    vector<NetGroup> groups;    // nets sharing a region; a net whose end points lie in two
+                                // regions joins them
+};
+
+RegionMap find_regions(const Grid& g);
+
+#endif
@@ -0,0 +1,448 @@
+#include "result_io.h"
+#include "trace.h"
+#include <charconv>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+static const size_t BLOCK_SIZE = 1 << 20;  // bytes handed to fwrite at a time
+static const char DIRS[] = "UDLR+-";
+static const int DX[6] = {-1, 1, 0, 0, 0, 0};
+static const int DY[6] = {0, 0, -1, 1, 0, 0};
+static const int DL[6] = {0, 0, 0, 0, 1, -1};
+
+static int dir_index(char d){
+    const char* p = strchr(DIRS, d);
+    return (p && d) ? p - DIRS : -1;
+}
+
+ResultWriter::ResultWriter(const string& filename, bool binary, int M, int N, size_t net_count, int L)
+    : binary(binary), L(L), buffer(BLOCK_SIZE + 256) {
+    out = fopen(filename.c_str(), "wb");
+    if (out) write_header(M, N, net_count);
+}
+
+ResultWriter::ResultWriter(string& sink, bool binary, int M, int N, size_t net_count, int L)
+    : sink(&sink), binary(binary), L(L), buffer(BLOCK_SIZE + 256) {
+    write_header(M, N, net_count);
+}
+
+void ResultWriter::write_header(int M, int N, size_t net_count){
+    if (binary) {
+        put_text("MZRB", 4);
+        put_u32(VERSION);
+        put_u32(M);
+        put_u32(N);
+        put_u32(net_count);
+        put_u32(L);
+    }
+    else {
+        put_text("MAZEROUTE ", 10);
+        put_int(VERSION); put_text(" ", 1);
+        put_int(M); put_text(" ", 1);
+        put_int(N); put_text(" ", 1);
+        put_int(net_count); put_text(" ", 1);
+        put_int(L); put_text("\n", 1);
+    }
+}
+
+ResultWriter::~ResultWriter(){
+    close();
+}
+
+bool ResultWriter::close(){
+    if (!is_open()) return !failed;
+    flush();
+    if (out && fclose(out) != 0) failed = true;
+    out = nullptr;
+    sink = nullptr;
+    return !failed;
+}
+
+void ResultWriter::flush(){
+    if (used && sink) sink->append(buffer.data(), used);
+    else if (used && fwrite(buffer.data(), 1, used, out) != used) failed = true;
+    used = 0;
+}
+
+void ResultWriter::put_text(const char* s, size_t len){
+    if (used + len > buffer.size()) flush();
+    if (len > buffer.size()) {
+        if (sink) sink->append(s, len);
+        else if (fwrite(s, 1, len, out) != len) failed = true;
+        return;
+    }
+    memcpy(buffer.data() + used, s, len);
+    used += len;
+}
+
+void ResultWriter::put_u32(uint32_t v){
+    char b[4] = {(char)(v & 0xff), (char)((v >> 8) & 0xff), (char)((v >> 16) & 0xff), (char)(v >> 24)};
+    put_text(b, 4);
+}
+
+void ResultWriter::put_varint(uint32_t v){
+    char b[5];
+    size_t n = 0;
+    while (v >= 0x80) {
+        b[n++] = (char)((v & 0x7f) | 0x80);
+        v >>= 7;
+    }
+    b[n++] = (char)v;
+    put_text(b, n);
+}
+
+void ResultWriter::put_int(long long v){
+    char b[24];
+    auto res = to_chars(b, b + sizeof(b), v);
+    put_text(b, res.ptr - b);
+}
+
+void ResultWriter::write(const RoutedNet& net){
+    if (!is_open()) return;
+    if (binary) {
+        put_u32(net.net_id);
+        put_u32(net.steps);
+        if (net.steps < 0) return;
+        put_varint(net.sx);
+        put_varint(net.sy);
+        if (L > 1) put_varint(net.sl);
+        put_varint(net.runs.size());
+        for (const auto& [d, len] : net.runs)
+            put_varint(((uint32_t)len << 3) | dir_index(d));
+    }
+    else {
+        put_int(net.net_id); put_text(" ", 1);
+        put_int(net.steps);
+        if (net.steps >= 0) {
+            put_text(" ", 1); put_int(net.sx);
+            put_text(" ", 1); put_int(net.sy);
+            if (L > 1) {
+                put_text(" ", 1); put_int(net.sl);
+            }
+            put_text(" ", 1);
+            for (const auto& [d, len] : net.runs) {
+                put_text(&d, 1);
+                put_int(len);
+            }
+        }
+        put_text("\n", 1);
+    }
+    if (used >= BLOCK_SIZE) flush();
+}
+
+RoutedNet encode_route(const Grid& g, int net_id, int steps){
+    RoutedNet net;
+    net.net_id = net_id;
+    net.steps = steps;
+    auto it = g.routes.find(net_id);
+    if (steps < 0 || it == g.routes.end() || it->second.empty()) {
+        net.steps = steps < 0 ? steps : -1;
+        return net;
+    }
+
+    const vector<Cell*>& route = it->second;
+    net.sx = route[0]->x;
+    net.sy = route[0]->y;
+    for (size_t k = 1; k < route.size(); ++k) {
+        int dx = route[k]->x - route[k - 1]->x, dy = route[k]->y - route[k - 1]->y;
+        char d = dx < 0 ? 'U' : dx > 0 ? 'D' : dy < 0 ? 'L' : 'R';
+        if (!net.runs.empty() && net.runs.back().first == d)
+            net.runs.back().second++;
+        else
+            net.runs.push_back({d, 1});
+    }
+    return net;
+}
+
+bool write_results(const string& filename, const Grid& g, const map<int,int>& id_to_steps, bool binary){
+    TraceSpan span("write_results");
+    ResultWriter writer(filename, binary, g.M, g.N, id_to_steps.size());
+    if (!writer.is_open()) {
+        cout << "Cannot write the result file " << filename << "!\n";
+        return false;
+    }
+    for (const auto& [id, steps] : id_to_steps)
+        writer.write(encode_route(g, id, steps));
+    return writer.close();
+}
+
+string format_results(const Grid& g, const map<int,int>& id_to_steps, bool binary){
+    string data;
+    ResultWriter writer(data, binary, g.M, g.N, id_to_steps.size());
+    for (const auto& [id, steps] : id_to_steps)
+        writer.write(encode_route(g, id, steps));
+    writer.close();
+    return data;
+}
+
+// True if the runs of a routed net give exactly `steps` cells: the start cell plus one per step
+static bool runs_match_steps(const RoutedNet& net){
+    long long cells = 1;
+    for (const auto& [d, len] : net.runs) {
+        if (len < 0 || dir_index(d) < 0) return false;
+        cells += len;
+        if (cells > net.steps) return false;
+    }
+    return cells == net.steps;
+}
+
+bool route_fits(const RoutedNet& net, int M, int N, int L){
+    if (net.steps < 0) return true;
+    return net.steps <= (long long)M * N * L && runs_match_steps(net);
+}
+
+vector<array<int, 3>> expand_layered_route(const RoutedNet& net){
+    vector<array<int, 3>> cells;
+    if (net.steps < 0 || !runs_match_steps(net)) return cells;
+    cells.reserve(net.steps);
+    int l = net.sl, x = net.sx, y = net.sy;
+    cells.push_back({l, x, y});
+    for (const auto& [d, len] : net.runs) {
+        int k = dir_index(d);
+        for (int step = 0; step < len; ++step) {
+            l += DL[k], x += DX[k], y += DY[k];
+            cells.push_back({l, x, y});
+        }
+    }
+    return cells;
+}
+
+vector<pair<int, int>> expand_route(const RoutedNet& net){
+    vector<pair<int, int>> cells;
+    if (net.steps < 0 || !runs_match_steps(net)) return cells;
+    cells.reserve(net.steps);
+    int x = net.sx, y = net.sy;
+    cells.push_back({x, y});
+    for (const auto& [d, len] : net.runs) {
+        int k = dir_index(d);
+        for (int step = 0; step < len; ++step) {
+            x += DX[k], y += DY[k];
+            cells.push_back({x, y});
+        }
+    }
+    return cells;
+}
+
+bool apply_results(const RoutedResult& result, Grid& g, map<int,int>& id_to_steps){
+    if (result.M != g.M || result.N != g.N || result.L != 1 || result.nets.size() != g.net_points.size()) return false;
+
+    // Check everything before touching the grid
+    vector<vector<pair<int, int>>> cells(result.nets.size());
+    vector<bool> used((size_t)g.M * g.N, false);
+    for (size_t k = 0; k < result.nets.size(); ++k) {
+        const RoutedNet& net = result.nets[k];
+        auto it = g.net_points.find(net.net_id);
+        if (it == g.net_points.end()) return false;
+        if (net.steps < 0) continue;
+        // A damaged file must not make expand_route() allocate for it
+        if (!route_fits(net, g.M, g.N)) return false;
+        for (const auto& run : net.runs)
+            if (run.first == '+' || run.first == '-') return false;
+
+        cells[k] = expand_route(net);
+        const vector<pair<int, int>>& route = cells[k];
+        if ((int)route.size() != net.steps || route.size() < 2) return false;
+        Cell *start = it->second.first, *end = it->second.second;
+        if (route.front() != make_pair(start->x, start->y) || route.back() != make_pair(end->x, end->y))
+            return false;
+        for (size_t i = 1; i + 1 < route.size(); ++i) {
+            auto [x, y] = route[i];
+            if (x < 0 || x >= g.M || y < 0 || y >= g.N) return false;
+            const Cell& c = g.grid[x][y];
+            if (!c.is_space || c.path_id != -1 || used[(size_t)x * g.N + y]) return false;
+            used[(size_t)x * g.N + y] = true;
+        }
+    }
+
+    id_to_steps.clear();
+    for (size_t k = 0; k < result.nets.size(); ++k) {
+        const RoutedNet& net = result.nets[k];
+        id_to_steps[net.net_id] = net.steps;
+        if (net.steps < 0) continue;
+        g.will_write_net(net.net_id);
+        vector<Cell*>& route = g.routes[net.net_id];
+        route.clear();
+        for (auto [x, y] : cells[k]) {
+            g.will_write(g.grid[x][y]);
+            g.grid[x][y].path_id = net.net_id;
+            route.push_back(&g.grid[x][y]);
+        }
+    }
+    return true;
+}
+
+// Parsing
+namespace {
+
+struct Cursor {
+    const char* p;
+    const char* end;
+    bool ok = true;
+
+    uint32_t u32(){
+        if (end - p < 4) { ok = false; return 0; }
+        const unsigned char* b = (const unsigned char*)p;
+        p += 4;
+        return b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24);
+    }
+    uint32_t varint(){
+        uint32_t v = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            if (p >= end) break;
+            unsigned char b = *p++;
+            v |= (uint32_t)(b & 0x7f) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        ok = false;
+        return 0;
+    }
+    void skip_blank(){
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+    }
+    long long integer(){
+        skip_blank();
+        long long v = 0;
+        auto res = from_chars(p, end, v);
+        if (res.ec != errc()) ok = false;
+        p = res.ptr;
+        return v;
+    }
+    void next_line(){
+        while (p < end && *p != '\n') ++p;
+        if (p < end) ++p;
+    }
+};
+
+bool parse_binary(Cursor& c, RoutedResult& result){
+    c.p += 4;
+    uint32_t version = c.u32();
+    if (version < 1 || version > (uint32_t)ResultWriter::VERSION) return false;
+    result.M = c.u32();
+    result.N = c.u32();
+    uint32_t count = c.u32();
+    if (version >= 3) result.L = c.u32();
+    int shift = version >= 3 ? 3 : 2;
+    if (!c.ok || result.L < 1 || count > (size_t)(c.end - c.p) / 8) return false;  // every net takes at least 8 bytes
+    result.nets.resize(count);
+    for (RoutedNet& net : result.nets) {
+        net.net_id = (int)c.u32();
+        net.steps = (int)c.u32();
+        if (net.steps < 0) continue;
+        net.sx = c.varint();
+        net.sy = c.varint();
+        if (result.L > 1) net.sl = c.varint();
+        net.runs.resize(c.varint());
+        for (auto& run : net.runs) {
+            uint32_t v = c.varint();
+            if ((v & ((1 << shift) - 1)) > 5) return false;
+            run = {DIRS[v & ((1 << shift) - 1)], (int)(v >> shift)};
+        }
+        if (!c.ok) return false;
+    }
+    return c.ok;
+}
+
+bool parse_text(Cursor& c, RoutedResult& result){
+    c.p += 10;  // "MAZEROUTE "
+    long long version = c.integer();
+    if (version < 1 || version > ResultWriter::VERSION) return false;
+    result.M = c.integer();
+    result.N = c.integer();
+    long long count = c.integer();
+    if (version >= 3) result.L = c.integer();
+    if (!c.ok || result.L < 1 || count < 0 || count > c.end - c.p) return false;
+    c.next_line();
+
+    result.nets.resize(count);
+    for (RoutedNet& net : result.nets) {
+        net.net_id = c.integer();
+        net.steps = c.integer();
+        if (net.steps >= 0) {
+            net.sx = c.integer();
+            net.sy = c.integer();
+            if (result.L > 1) net.sl = c.integer();
+            c.skip_blank();
+            while (c.p < c.end && dir_index(*c.p) != -1) {
+                char d = *c.p++;
+                net.runs.push_back({d, (int)c.integer()});
+            }
+        }
+        if (!c.ok) return false;
+        c.next_line();
+    }
+    return true;
+}
+
+}
+
+bool parse_results(const char* data, size_t size, RoutedResult& result){
+    result = RoutedResult();
+    Cursor c{data, data + size};
+    if (size >= 4 && memcmp(data, "MZRB", 4) == 0)
+        return parse_binary(c, result);
+    if (size >= 10 && memcmp(data, "MAZEROUTE ", 10) == 0)
+        return parse_text(c, result);
+    return false;
+}
+
+bool read_results(const string& filename, RoutedResult& result){
+    FILE* in = fopen(filename.c_str(), "rb");
+    if (!in) return false;
+    fseek(in, 0, SEEK_END);
+    long size = ftell(in);
+    fseek(in, 0, SEEK_SET);
+    vector<char> data(size > 0 ? size : 0);
+    bool ok = size >= 0 && fread(data.data(), 1, data.size(), in) == data.size();
+    fclose(in);
+    return ok && parse_results(data.data(), data.size(), result);
+}
+
+bool map_results(const string& filename, RoutedResult& result){
+    TraceSpan span("map_results");
+    bool ok = false;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) {
+            const char* data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (data) {
+                ok = parse_results(data, (size_t)size.QuadPart, result);
+                UnmapViewOfFile(data);
+            }
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    // An empty file cannot be mapped (and is no result file either)
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            madvise(data, st.st_size, MADV_SEQUENTIAL);
+            ok = parse_results((const char*)data, st.st_size, result);
+            munmap(data, st.st_size);
+        }
+    }
+    close(fd);
+#endif
+    return ok;
+}
@@ -0,0 +1,102 @@
+#ifndef _RESULT_IO_H
+#define _RESULT_IO_H
+
+using namespace std;
+
+#include <array>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <map>
+#include "objects.h"
+
+// Routed geometry of one net: the start cell followed by run-length-encoded moves.
+// Directions are 'U' (x - 1), 'D' (x + 1), 'L' (y - 1) and 'R' (y + 1); on layered mazes
+// also '+' (via to layer + 1) and '-' (via to layer - 1).
+struct RoutedNet {
+    int net_id = -1;
+    int steps = -1;                 // number of cells on the route, -1 if routing failed,
+                                    // NOT_ATTEMPTED if the deadline came first
+    int sx = -1, sy = -1;           // start cell
+    int sl = 0;                     // start layer
+    vector<pair<char, int>> runs;   // (direction, length)
+};
+
+struct RoutedResult {
+    int M = 0, N = 0, L = 1;
+    vector<RoutedNet> nets;
+};
+
+// Streams routed nets to a file in large blocks.
+//
+// Text format:
+//   MAZEROUTE <version> <M> <N> <net count> <L>
+//   <id> <steps> <sx> <sy> <runs>      e.g. "3 12 0 4 D3R2D6", one line per routed net
+//   <id> <steps> <sx> <sy> <sl> <runs> when L > 1, e.g. "3 14 0 4 0 D3+1R2D6"
+//   <id> -1                            for a failed net
+//   <id> -2                            for a net not attempted before the deadline (version 2)
+//
+// Binary format (little endian): "MZRB", u32 version, u32 M, u32 N, u32 net count, u32 L, then
+// per net i32 id, i32 steps and, for routed nets, varint sx, sy, sl (only when L > 1), run count
+// and one varint (length << 3 | direction) per run with direction 0..5 = U, D, L, R, +, -.
+//
+// Version 1 and 2 files have no layer count (and no vias) and encode runs as length << 2 | direction.
+class ResultWriter {
+public:
+    static const int VERSION = 3;  // readers accept 1 .. VERSION
+
+    ResultWriter(const string& filename, bool binary, int M, int N, size_t net_count, int L = 1);
+    // Appends to `sink` instead of a file
+    ResultWriter(string& sink, bool binary, int M, int N, size_t net_count, int L = 1);
+    ~ResultWriter();
+
+    bool is_open() const { return out != nullptr || sink != nullptr; }
+    void write(const RoutedNet& net);
+    // Returns false if any write failed
+    bool close();
+
+private:
+    void write_header(int M, int N, size_t net_count);
+    void put_u32(uint32_t v);
+    void put_varint(uint32_t v);
+    void put_int(long long v);
+    void put_text(const char* s, size_t len);
+    void flush();
+
+    FILE* out = nullptr;
+    string* sink = nullptr;
+    bool binary;
+    int L;
+    bool failed = false;
+    vector<char> buffer;
+    size_t used = 0;
+};
+
+// Encodes the committed route of `net_id` in g.routes
+RoutedNet encode_route(const Grid& g, int net_id, int steps);
+
+// Writes every net of id_to_steps with its full geometry
+bool write_results(const string& filename, const Grid& g, const map<int,int>& id_to_steps, bool binary);
+// Same, into memory
+string format_results(const Grid& g, const map<int,int>& id_to_steps, bool binary);
+
+// Reads a text or binary result file (detected from its header)
+bool read_results(const string& filename, RoutedResult& result);
+// Same, parsing the file through a read-only memory mapping instead of a copy of it
+bool map_results(const string& filename, RoutedResult& result);
+bool parse_results(const char* data, size_t size, RoutedResult& result);
+
+// True if the steps of `net` fit an M x N x L maze and match its runs. Check it before
+// expanding a route read from a file: the expansions allocate `steps` cells.
+bool route_fits(const RoutedNet& net, int M, int N, int L = 1);
+// Cells of a routed net, from start to end (vias are not expected on 2D mazes); empty when
+// the steps do not match the runs
+vector<pair<int, int>> expand_route(const RoutedNet& net);
+// Same with layers: (layer, x, y) per cell
+vector<array<int, 3>> expand_layered_route(const RoutedNet& net);
+
+// Commits the routes of `result` to `g` (which must be the unrouted maze they were computed
+// for) and fills id_to_steps. Returns false and leaves `g` untouched if they do not fit.
+bool apply_results(const RoutedResult& result, Grid& g, map<int,int>& id_to_steps);
+
+#endif
@@ -0,0 +1,387 @@
+#include "server.h"
+#include "mazeroute.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+const uint32_t MAX_FRAME = 1u << 30;
+
+long read_some(int fd, char* p, size_t n){
+#ifdef _WIN32
+    return _read(fd, p, (unsigned)min(n, (size_t)1 << 30));
+#else
+    return ::read(fd, p, n);
+#endif
+}
+
+long write_some(int fd, const char* p, size_t n){
+#ifdef _WIN32
+    return _write(fd, p, (unsigned)min(n, (size_t)1 << 30));
+#else
+    return ::write(fd, p, n);
+#endif
+}
+
+bool read_all(int fd, char* p, size_t n){
+    while (n) {
+        long got = read_some(fd, p, n);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        p += got;
+        n -= got;
+    }
+    return true;
+}
+
+bool write_all(int fd, const char* p, size_t n){
+    while (n) {
+        long put = write_some(fd, p, n);
+        if (put < 0 && errno == EINTR) continue;
+        if (put <= 0) return false;
+        p += put;
+        n -= put;
+    }
+    return true;
+}
+
+bool read_frame(int fd, string& payload){
+    unsigned char len[4];
+    if (!read_all(fd, (char*)len, 4)) return false;
+    uint32_t size = len[0] | (len[1] << 8) | (len[2] << 16) | ((uint32_t)len[3] << 24);
+    if (size > MAX_FRAME) return false;
+    payload.resize(size);
+    return read_all(fd, &payload[0], size);
+}
+
+bool write_frame(int fd, const string& payload){
+    uint32_t size = payload.size();
+    char len[4] = {(char)(size & 0xff), (char)((size >> 8) & 0xff), (char)((size >> 16) & 0xff), (char)(size >> 24)};
+    return write_all(fd, len, 4) && write_all(fd, payload.data(), payload.size());
+}
+
+// One client. Responses may finish out of order on the workers; they are held back until
+// every earlier response on the connection has been written.
+struct Connection {
+    int in_fd, out_fd;
+    bool owns_fd;
+    uint64_t next_seq = 0;      // only used by the reader thread
+    atomic<bool> reader_done{false};
+
+    mutex lock;
+    uint64_t next_out = 0;
+    map<uint64_t, string> ready;
+    bool broken = false;
+
+    Connection(int in, int out, bool owns) : in_fd(in), out_fd(out), owns_fd(owns) {}
+    ~Connection(){
+#ifndef _WIN32
+        if (owns_fd) ::close(in_fd);
+#endif
+    }
+
+    void respond(uint64_t seq, string payload){
+        lock_guard<mutex> guard(lock);
+        ready[seq] = move(payload);
+        for (auto it = ready.find(next_out); it != ready.end(); it = ready.find(next_out)) {
+            if (!broken) broken = !write_frame(out_fd, it->second);
+            ready.erase(it);
+            next_out++;
+        }
+    }
+};
+
+struct Job {
+    shared_ptr<Connection> conn;
+    uint64_t seq;
+    string request;
+    chrono::steady_clock::time_point queued;
+};
+
+class Server {
+public:
+    explicit Server(int workers){
+        for (int w = 0; w < workers; ++w) threads.emplace_back(&Server::work, this);
+    }
+    ~Server(){
+        {
+            lock_guard<mutex> guard(lock);
+            stop_workers = true;
+        }
+        cv.notify_all();
+        for (auto& t : threads) t.join();
+    }
+
+    function<void()> on_shutdown;
+
+    bool stopping() const { return shutdown_requested; }
+
+    void submit(const shared_ptr<Connection>& conn, string request){
+        uint64_t seq = conn->next_seq++;
+        string command = request.substr(0, request.find_first_of(" \r\n"));
+        if (command == "ROUTE") {
+            {
+                lock_guard<mutex> guard(lock);
+                queue.push_back({conn, seq, move(request), chrono::steady_clock::now()});
+                max_depth = max(max_depth, queue.size());
+            }
+            cv.notify_one();
+        }
+        else if (command == "STATS") {
+            conn->respond(seq, "OK\n" + stats());
+        }
+        else if (command == "SHUTDOWN") {
+            shutdown_requested = true;
+            conn->respond(seq, "OK\n");
+            if (on_shutdown) on_shutdown();
+        }
+        else {
+            {
+                lock_guard<mutex> guard(lock);
+                errors++;
+            }
+            conn->respond(seq, "ERROR unknown command " + command + "\n");
+        }
+    }
+
+    // Waits until every queued request has been answered
+    void drain(){
+        unique_lock<mutex> guard(lock);
+        idle.wait(guard, [&]() { return queue.empty() && busy == 0; });
+    }
+
+private:
+    void work(){
+        MazeRouter router;  // kept for the worker's whole life, solver environments included
+        while (true) {
+            Job job;
+            {
+                unique_lock<mutex> guard(lock);
+                cv.wait(guard, [&]() { return stop_workers || !queue.empty(); });
+                if (queue.empty()) return;
+                job = move(queue.front());
+                queue.pop_front();
+                busy++;
+            }
+
+            bool ok = true;
+            string response = route(router, job.request, ok);
+            job.conn->respond(job.seq, move(response));
+
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - job.queued).count();
+            lock_guard<mutex> guard(lock);
+            requests++;
+            if (!ok) errors++;
+            latency_total += ms;
+            latency_max = max(latency_max, ms);
+            if (recent.size() < RECENT) recent.push_back(ms);
+            else recent[recent_next++ % RECENT] = ms;
+            if (--busy == 0 && queue.empty()) idle.notify_all();
+        }
+    }
+
+    string route(MazeRouter& router, const string& request, bool& ok){
+        size_t eol = request.find('\n');
+        istringstream options(request.substr(0, eol));
+        string body = eol == string::npos ? "" : request.substr(eol + 1);
+
+        RouteOptions opt;
+        bool binary = false;
+        string arg;
+        options >> arg;  // ROUTE
+        try {
+            while (options >> arg) {
+                if (arg == "--astar") opt.algorithm = RouteOptions::ASTAR;
+                else if (arg == "--ilp") opt.algorithm = RouteOptions::ILP;
+                else if (arg == "--hadlock") opt.algorithm = RouteOptions::HADLOCK;
+                else if (arg == "--line-probe") opt.algorithm = RouteOptions::LINEPROBE;
+                else if (arg == "--portfolio") opt.portfolio = true;
+                else if (arg == "--local-solver") opt.local_solver = true;
+                else if (arg == "--binary") binary = true;
+                else if (arg == "--alt" && options >> arg) opt.algorithm = RouteOptions::ASTAR, opt.landmarks = stoi(arg);
+                else if (arg == "--max-iter" && options >> arg) opt.max_iteration = stoi(arg);
+                else if (arg == "--time-limit" && options >> arg) opt.time_limit = stod(arg);
+                else if (arg == "--deadline" && options >> arg) opt.deadline = stod(arg);
+                else {
+                    ok = false;
+                    return "ERROR unknown option " + arg + "\n";
+                }
+            }
+        }
+        catch (const exception&) {
+            ok = false;
+            return "ERROR bad value for an option\n";
+        }
+        Grid g;
+        string error;
+        bool parsed;
+        if (!body.empty() && body[0] == '@') {
+            string path = body.substr(1);
+            while (!path.empty() && isspace((unsigned char)path.back())) path.pop_back();
+            ifstream input(path);
+            if (input.fail()) {
+                ok = false;
+                return "ERROR cannot read " + path + "\n";
+            }
+            parsed = parse_maze(input, g, error);
+        }
+        else {
+            istringstream input(body);
+            parsed = parse_maze(input, g, error);
+        }
+        if (!parsed) {
+            ok = false;
+            return "ERROR " + error + "\n";
+        }
+
+        map<int,int> result = router.route(g, opt);
+        return "OK\n" + format_results(g, result, binary);
+    }
+
+    string stats(){
+        lock_guard<mutex> guard(lock);
+        vector<double> sorted = recent;
+        sort(sorted.begin(), sorted.end());
+        auto percentile = [&](double p) {
+            return sorted.empty() ? 0.0 : sorted[min(sorted.size() - 1, (size_t)(p * sorted.size()))];
+        };
+        ostringstream out;
+        out << "completed " << requests << "\n"
+            << "errors " << errors << "\n"
+            << "queue_depth " << queue.size() << "\n"
+            << "max_queue_depth " << max_depth << "\n"
+            << "in_flight " << busy << "\n"
+            << "workers " << threads.size() << "\n"
+            << "latency_ms_mean " << (requests ? latency_total / requests : 0.0) << "\n"
+            << "latency_ms_p50 " << percentile(0.5) << "\n"
+            << "latency_ms_p99 " << percentile(0.99) << "\n"
+            << "latency_ms_max " << latency_max << "\n";
+        return out.str();
+    }
+
+    static const size_t RECENT = 4096;  // latency samples kept for the percentiles
+
+    mutex lock;
+    condition_variable cv, idle;
+    deque<Job> queue;
+    int busy = 0;
+    bool stop_workers = false;
+    atomic<bool> shutdown_requested{false};
+    vector<thread> threads;
+
+    long long requests = 0, errors = 0;
+    size_t max_depth = 0;
+    double latency_total = 0, latency_max = 0;
+    vector<double> recent;
+    size_t recent_next = 0;
+};
+
+void read_requests(Server& server, const shared_ptr<Connection>& conn){
+    string payload;
+    while (!server.stopping() && read_frame(conn->in_fd, payload))
+        server.submit(conn, move(payload));
+    conn->reader_done = true;
+}
+
+}
+
+int serve(const string& endpoint, int workers){
+    workers = max(1, workers);
+
+    if (endpoint == "-") {
+        // stdout carries the responses; anything else printed goes to stderr
+        cout.rdbuf(cerr.rdbuf());
+#ifdef _WIN32
+        _setmode(0, _O_BINARY);
+        _setmode(1, _O_BINARY);
+#endif
+        Server server(workers);
+        read_requests(server, make_shared<Connection>(0, 1, false));
+        server.drain();
+        return 0;
+    }
+
+#ifdef _WIN32
+    cerr << "Unix socket endpoints are not supported on Windows, use --serve -" << endl;
+    return 1;
+#else
+    signal(SIGPIPE, SIG_IGN);  // a client hanging up must not kill the daemon
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (endpoint.size() >= sizeof(addr.sun_path)) {
+        cerr << "Socket path too long: " << endpoint << endl;
+        return 1;
+    }
+    endpoint.copy(addr.sun_path, endpoint.size());
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(endpoint.c_str());
+    if (listen_fd < 0 || bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listen_fd, 64) < 0) {
+        cerr << "Cannot listen on " << endpoint << endl;
+        if (listen_fd >= 0) close(listen_fd);
+        return 1;
+    }
+    cerr << "Serving on " << endpoint << " with " << workers << " workers" << endl;
+
+    Server server(workers);
+    server.on_shutdown = [listen_fd]() { shutdown(listen_fd, SHUT_RDWR); };
+
+    struct Client {
+        shared_ptr<Connection> conn;
+        thread reader;
+    };
+    vector<Client> clients;
+    while (!server.stopping()) {
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        // Forget the clients that have hung up
+        for (auto it = clients.begin(); it != clients.end();) {
+            if (it->conn->reader_done) {
+                it->reader.join();
+                it = clients.erase(it);
+            }
+            else ++it;
+        }
+        auto conn = make_shared<Connection>(fd, fd, true);
+        clients.push_back({conn, thread(read_requests, ref(server), conn)});
+    }
+
+    // Stop reading; the requests already queued are still answered
+    for (Client& c : clients) shutdown(c.conn->in_fd, SHUT_RD);
+    for (Client& c : clients) c.reader.join();
+    server.drain();
+    close(listen_fd);
+    unlink(endpoint.c_str());
+    return 0;
+#endif
+}
@@ -0,0 +1,28 @@
+#ifndef _SERVER_H
+#define _SERVER_H
+
+#include <string>
+
+using namespace std;
+
+// Long-running routing daemon.
+//
+// Requests and responses are frames: a 4-byte little-endian payload length followed by the
+// payload. The first line of a request is the command:
+//
+//   ROUTE [--astar] [--alt K] [--hadlock] [--line-probe] [--ilp] [--max-iter N] [--time-limit T] [--local-solver] [--portfolio] [--deadline S] [--binary]
+//   <maze in the input format>                 (or a single line "@<path to a maze file>")
+//
+//   STATS                                      request count, queue depth and latency
+//   SHUTDOWN                                   finish the queued requests and exit
+//
+// A response is "OK\n" followed by the result file (see result_io.h; text unless --binary)
+// or the stats, or "ERROR <message>\n". Requests are routed in parallel by `workers` threads,
+// each keeping its Router and solver environments between requests; responses on one
+// connection come back in request order.
+//
+// `endpoint` is the path of a Unix domain socket to listen on, or "-" to serve a single
+// client over stdin/stdout. Returns the process exit code.
+int serve(const string& endpoint, int workers);
+
+#endif
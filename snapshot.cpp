@@ -0,0 +1,73 @@
+#include "snapshot.h"
+
+using namespace std;
+
+void RouteSnapshot::init(const Grid& g){
+    lock_guard<mutex> lock(writer_lock);
+    N = g.N;
+    working = RouteFrame();
+    working.owner.assign((size_t)g.M * g.N, -1);
+    for (int i = 0; i < g.M; ++i)
+        for (int j = 0; j < g.N; ++j)
+            working.owner[(size_t)i * N + j] = g.grid[i][j].path_id;
+    publish(true);
+}
+
+void RouteSnapshot::commit(int net_id, int steps, const vector<Cell*>& cells){
+    lock_guard<mutex> lock(writer_lock);
+    for (Cell* c : cells)
+        working.owner[(size_t)c->x * N + c->y] = net_id;
+    working.id_to_steps[net_id] = steps;
+    if (steps > 0) working.routed++;
+    publish(false);
+}
+
+void RouteSnapshot::commit(int net_id, int steps, const PathView& cells){
+    lock_guard<mutex> lock(writer_lock);
+    for (int idx : cells)
+        working.owner[idx] = net_id;  // same linear layout (x * N + y)
+    working.id_to_steps[net_id] = steps;
+    if (steps > 0) working.routed++;
+    publish(false);
+}
+
+void RouteSnapshot::update(const Grid& g, const vector<Cell*>& cells, const map<int,int>& id_to_steps){
+    lock_guard<mutex> lock(writer_lock);
+    for (Cell* c : cells)
+        working.owner[(size_t)c->x * N + c->y] = g.grid[c->x][c->y].path_id;
+    working.id_to_steps = id_to_steps;
+    working.routed = 0;
+    for (const auto& [id, steps] : id_to_steps)
+        if (steps > 0) working.routed++;
+    publish(true);
+}
+
+void RouteSnapshot::finish(const map<int,int>& id_to_steps){
+    lock_guard<mutex> lock(writer_lock);
+    working.id_to_steps = id_to_steps;
+    working.routed = 0;
+    for (const auto& [id, steps] : id_to_steps)
+        if (steps > 0) working.routed++;
+    working.done = true;
+    publish(true);
+}
+
+// Must be called with writer_lock held
+void RouteSnapshot::publish(bool force){
+    auto now = chrono::steady_clock::now();
+    if (!force && now - last_publish < publish_interval) return;
+    last_publish = now;
+
+    staging = working;  // reuses the buffers handed back by the GUI
+    lock_guard<mutex> lock(swap_lock);
+    swap(staging, pending);
+    has_pending = true;
+}
+
+bool RouteSnapshot::acquire(RouteFrame& out){
+    lock_guard<mutex> lock(swap_lock);
+    if (!has_pending) return false;
+    swap(out, pending);
+    has_pending = false;
+    return true;
+}
@@ -0,0 +1,64 @@
+#ifndef _SNAPSHOT_H
+#define _SNAPSHOT_H
+
+using namespace std;
+
+#include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include "objects.h"
+#include "path.h"
+
+// One published view of the routing state.
+struct RouteFrame {
+    vector<int> owner;          // owner[i * N + j] is the path_id of cell (i, j)
+    map<int,int> id_to_steps;   // nets committed so far
+    int routed = 0;             // nets with steps > 0
+    bool done = false;          // the router has finished
+};
+
+// Hands routing progress from the routing thread to the GUI thread.
+// The router writes into a private frame, copies it into a staging frame and swaps
+// that with the pending one under a short lock; the GUI swaps the pending frame out
+// the same way, so neither side ever waits on the other's copy or render.
+class RouteSnapshot {
+public:
+    void init(const Grid& g);
+
+    // Called by the router whenever a net is committed (steps == -1 for a failed net)
+    void commit(int net_id, int steps, const vector<Cell*>& cells);
+    void commit(int net_id, int steps, const PathView& cells);
+    // Re-reads the ownership of `cells` from the grid after an incremental edit
+    void update(const Grid& g, const vector<Cell*>& cells, const map<int,int>& id_to_steps);
+    // Publishes the final result; later acquire() calls return done == true
+    void finish(const map<int,int>& id_to_steps);
+
+    // Called by the GUI; returns true and fills `out` when a newer frame exists
+    bool acquire(RouteFrame& out);
+
+    void cancel() { stop = true; }
+    bool cancelled() const { return stop; }
+
+    // Minimum time between two published frames while routing is running
+    chrono::milliseconds publish_interval{30};
+
+private:
+    void publish(bool force);
+
+    int N = 0;
+
+    mutex writer_lock;      // serialises routers committing from several threads
+    RouteFrame working;
+    RouteFrame staging;
+    chrono::steady_clock::time_point last_publish;
+
+    mutex swap_lock;
+    RouteFrame pending;
+    bool has_pending = false;
+
+    atomic<bool> stop{false};
+};
+
+#endif
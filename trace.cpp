@@ -0,0 +1,145 @@
+#include "trace.h"
+#ifdef ALLOC_PROFILE
+#include "alloc_profile.h"
+#endif
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    const char* arg_name;
+    long long arg;
+    int64_t start, duration;  // ns
+};
+
+// Written by its thread only; readers see the first `count` events
+struct Chunk {
+    static const size_t SIZE = 4096;
+    TraceEvent events[SIZE];
+    atomic<size_t> count{0};
+    atomic<Chunk*> next{nullptr};
+};
+
+struct ThreadBuffer {
+    int tid;
+    Chunk* head;
+    Chunk* tail;
+};
+
+atomic<bool> enabled{false};
+chrono::steady_clock::time_point origin;
+
+// Buffers and chunks are never freed, so threads may end before the trace is written.
+// The lock is only taken when a thread records its first event.
+mutex registry_lock;
+vector<unique_ptr<ThreadBuffer>> buffers;
+
+ThreadBuffer* this_thread_buffer(){
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (!buffer) {
+        Chunk* first = new Chunk();
+        lock_guard<mutex> guard(registry_lock);
+        buffers.emplace_back(new ThreadBuffer{(int)buffers.size(), first, first});
+        buffer = buffers.back().get();
+    }
+    return buffer;
+}
+
+int64_t now_ns(){
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - origin).count();
+}
+
+void record(const TraceEvent& event){
+    ThreadBuffer* buffer = this_thread_buffer();
+    Chunk* chunk = buffer->tail;
+    size_t k = chunk->count.load(memory_order_relaxed);
+    if (k == Chunk::SIZE) {
+        Chunk* next = new Chunk();
+        chunk->next.store(next, memory_order_release);
+        chunk = buffer->tail = next;
+        k = 0;
+    }
+    chunk->events[k] = event;
+    chunk->count.store(k + 1, memory_order_release);
+}
+
+// Names are literals from the code, only quotes and backslashes need escaping
+void put_string(FILE* out, const char* s){
+    fputc('"', out);
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') fputc('\\', out);
+        fputc(*s, out);
+    }
+    fputc('"', out);
+}
+
+}
+
+void start_trace(){
+    origin = chrono::steady_clock::now();
+    enabled.store(true);
+}
+
+bool trace_enabled(){
+    return enabled.load(memory_order_relaxed);
+}
+
+bool write_trace(const string& filename){
+    FILE* out = fopen(filename.c_str(), "w");
+    if (!out) return false;
+
+    vector<ThreadBuffer*> list;
+    {
+        lock_guard<mutex> guard(registry_lock);
+        for (auto& b : buffers) list.push_back(b.get());
+    }
+
+    fputs("{\"traceEvents\":[\n", out);
+    bool first = true;
+    for (ThreadBuffer* b : list) {
+        for (Chunk* c = b->head; c; c = c->next.load(memory_order_acquire)) {
+            size_t count = c->count.load(memory_order_acquire);
+            for (size_t k = 0; k < count; ++k) {
+                const TraceEvent& e = c->events[k];
+                fputs(first ? "" : ",\n", out);
+                first = false;
+                fputs("{\"name\":", out);
+                put_string(out, e.name);
+                fprintf(out, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f", b->tid, e.start / 1000.0,
+                        e.duration / 1000.0);
+                if (e.arg_name) {
+                    fputs(",\"args\":{", out);
+                    put_string(out, e.arg_name);
+                    fprintf(out, ":%lld}", e.arg);
+                }
+                fputc('}', out);
+            }
+        }
+    }
+    fputs("\n],\"displayTimeUnit\":\"ms\"}\n", out);
+    return fclose(out) == 0;
+}
+
+TraceSpan::TraceSpan(const char* name, const char* arg_name, long long arg)
+    : name(name), arg_name(arg_name), arg(arg) {
+#ifdef ALLOC_PROFILE
+    alloc_phase_push(name);
+#endif
+    if (enabled.load(memory_order_relaxed)) start = now_ns();
+}
+
+TraceSpan::~TraceSpan(){
+#ifdef ALLOC_PROFILE
+    alloc_phase_pop();
+#endif
+    if (start < 0) return;
+    record({name, arg_name, arg, start, now_ns() - start});
+}
@@ -0,0 +1,40 @@
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+// Phase timeline in the Chrome trace-event format (load it in chrome://tracing or Perfetto).
+//
+// A TraceSpan records one complete event from its construction to its destruction on the
+// calling thread. Every thread appends to its own buffer of fixed-size chunks and publishes
+// each event with a release store of the chunk's count, so recording takes no lock and
+// write_trace() may run while other threads are still recording.
+//
+// Nothing is recorded before start_trace(); a span then costs one relaxed atomic load.
+
+void start_trace();
+bool trace_enabled();
+// Writes the events recorded so far by every thread; false if the file cannot be written
+bool write_trace(const string& filename);
+
+class TraceSpan {
+public:
+    // `name` and `arg_name` must outlive the trace (string literals); `arg` is shown under
+    // `arg_name` in the viewer when that is set
+    explicit TraceSpan(const char* name, const char* arg_name = nullptr, long long arg = 0);
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name;
+    const char* arg_name;
+    long long arg;
+    int64_t start = -1;  // ns since start_trace(), -1 when tracing is off
+};
+
+#endif
@@ -1,12 +1,15 @@
 #include "utils.h"
+#include "trace.h"
 #include <fstream>
 #include <sstream>
 #include <vector>
 #include <iostream>
+#include <cctype>
 
 using namespace std;
 
 Grid read_maze(const string& filename) {
+    TraceSpan span("read_maze");
     ifstream input;
     input.open(filename);
     if(input.fail()){
@@ -14,15 +17,36 @@ Grid read_maze(const string& filename) {
         exit(1);
     }
 
+    Grid g;
+    string error;
+    if (!parse_maze(input, g, error)) {
+        cout << error << endl;
+        exit(1);
+    }
+    input.close();
+    return g;
+}
+
+bool parse_maze(istream& input, Grid& g, string& error) {
     int m, n;
-    input >> m >> n;
+    if (!(input >> m >> n) || m <= 0 || n <= 0) {
+        error = "Invalid maze size!";
+        return false;
+    }
 
-    Grid g(m,n);
+    g.M = m;
+    g.N = n;
+    g.grid.assign(m, vector<Cell>(n));
+    g.net_points.clear();
+    g.routes.clear();
     string token;
 
     for(int i = 0; i < m; i++){
         for(int j = 0; j < n; j++){
-            input >> token;
+            if (!(input >> token)) {
+                error = "Unexpected end of maze input!";
+                return false;
+            }
             Cell& cell = g.grid[i][j];
             cell.x = i;
             cell.y = j;
@@ -34,7 +58,7 @@ Grid read_maze(const string& filename) {
                 cell.path_id = -1;
                 cell.is_space = true;               
             }
-            else if (token.size() >= 2 && (token[0] == 'S' || token[0] == 'E')) {
+            else if (token.size() >= 2 && token.size() <= 10 && (token[0] == 'S' || token[0] == 'E') && isdigit(token[1])) {
                 char type = token[0]; // S or E
                 int net_id = stoi(token.substr(1));
             
@@ -50,19 +74,69 @@ Grid read_maze(const string& filename) {
                 }
             }
             else {
-                cout << "Invalid token in input: " << token << endl;
-                exit(1);
+                error = "Invalid token in input: " + token;
+                return false;
             }
         }
     }
     
     for (const auto& [id, pair] : g.net_points) {
         if (pair.first == nullptr || pair.second == nullptr) {
-            cout << "Missing S" << id << " or E" << id << "!\n";
-            exit(1);
+            error = "Missing S" + to_string(id) + " or E" + to_string(id) + "!";
+            return false;
         }
     }    
-
-    input.close();
-    return g;
+    return true;
 }
+
+
+// Edit list format, one edit per line ('#' starts a comment):
+//   add_obstacle X Y | remove_obstacle X Y
+//   add_net ID SX SY EX EY | remove_net ID
+//   move_start ID X Y | move_end ID X Y
+vector<Edit> read_edits(const string& filename) {
+    ifstream input(filename);
+    if(input.fail()){
+        cout << "Cannot read the edit file!\n";
+        exit(1);
+    }
+
+    vector<Edit> edits;
+    string line;
+    int line_no = 0;
+    while (getline(input, line)) {
+        line_no++;
+        size_t hash = line.find('#');
+        if (hash != string::npos) line.erase(hash);
+
+        istringstream ss(line);
+        string op;
+        if (!(ss >> op)) continue;
+
+        Edit e;
+        bool ok = false;
+        if (op == "add_obstacle" || op == "remove_obstacle") {
+            e.type = op == "add_obstacle" ? Edit::ADD_OBSTACLE : Edit::REMOVE_OBSTACLE;
+            ok = (bool)(ss >> e.x >> e.y);
+        }
+        else if (op == "add_net") {
+            e.type = Edit::ADD_NET;
+            ok = (bool)(ss >> e.net_id >> e.x >> e.y >> e.x2 >> e.y2);
+        }
+        else if (op == "remove_net") {
+            e.type = Edit::REMOVE_NET;
+            ok = (bool)(ss >> e.net_id);
+        }
+        else if (op == "move_start" || op == "move_end") {
+            e.type = op == "move_start" ? Edit::MOVE_START : Edit::MOVE_END;
+            ok = (bool)(ss >> e.net_id >> e.x >> e.y);
+        }
+
+        if (!ok) {
+            cout << "Invalid edit at line " << line_no << ": " << line << endl;
+            exit(1);
+        }
+        edits.push_back(e);
+    }
+    return edits;
+}
\ No newline at end of file
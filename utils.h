@@ -3,7 +3,12 @@
 
 #include "objects.h"
 #include <string>
+#include <istream>
 
+// Exits with a message if the file cannot be read or parsed
 Grid read_maze(const string& filename);
+// Parses a maze in the input format into `g`; returns false with `error` set instead of exiting
+bool parse_maze(istream& input, Grid& g, string& error);
+vector<Edit> read_edits(const string& filename);
 
 #endif
\ No newline at end of file